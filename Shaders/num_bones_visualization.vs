@@ -1,10 +1,8 @@
 #version 330 core
 
 layout(location = 0) in vec3 pos;
-layout(location = 1) in vec3 norm;
+layout(location = 1) in vec2 norm;
 layout(location = 2) in vec2 tex;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec2 bitangent;
 layout(location = 5) in ivec4 boneIds; 
 layout(location = 6) in vec4 weights;
 layout(location = 7) in int numBones;
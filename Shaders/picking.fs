@@ -0,0 +1,10 @@
+#version 330 core
+// mesh id, triangle id (both start from 1, 0 is the background) and depth of the fragment
+out uvec4 ids;
+
+uniform int meshID;
+
+void main()
+{
+    ids = uvec4(uint(meshID), uint(gl_PrimitiveID) + 1u, floatBitsToUint(gl_FragCoord.z), 0u);
+}
@@ -1,10 +1,8 @@
 #version 330 core
 
 layout(location = 0) in vec3 pos;
-layout(location = 1) in vec3 norm;
+layout(location = 1) in vec2 norm;
 layout(location = 2) in vec2 tex;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec2 bitangent;
 layout(location = 5) in ivec4 boneIds; 
 layout(location = 6) in vec4 weights;
 layout(location = 7) in int numBones;
@@ -16,6 +14,16 @@ uniform mat4 finalBonesMatrices[100];
 out vec3 Normal;
 out vec2 TexCoords;
 	
+// normals are sent octahedral encoded
+vec3 decodeNormal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
     mat4 cumulativeMatrix = mat4(1.0);
@@ -26,6 +34,6 @@ void main()
         cumulativeMatrix += (finalBonesMatrices[boneIds[i]] * weights[i]);
     }
     gl_Position =  projection * modelView * cumulativeMatrix * vec4(pos, 1.0);
-    Normal = normalize((modelView * cumulativeMatrix * vec4(norm, 0.0)).xyz);
+    Normal = normalize((modelView * cumulativeMatrix * vec4(decodeNormal(norm), 0.0)).xyz);
     TexCoords = tex;
 }
\ No newline at end of file
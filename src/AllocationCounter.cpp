@@ -0,0 +1,61 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+	thread_local size_t threadAllocations = 0;
+	thread_local size_t threadAllocatedBytes = 0;
+}
+
+size_t AllocationCounter::GetThreadAllocations()
+{
+	return threadAllocations;
+}
+
+size_t AllocationCounter::GetThreadAllocatedBytes()
+{
+	return threadAllocatedBytes;
+}
+
+// replacements of the global allocation functions, the nothrow versions forward to these ones
+void* operator new(std::size_t size)
+{
+	threadAllocations++;
+	threadAllocatedBytes += size;
+	if (size == 0)
+		size = 1;
+	while (true) {
+		if (void* ptr = std::malloc(size))
+			return ptr;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t size) noexcept
+{
+	std::free(ptr);
+}
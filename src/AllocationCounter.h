@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+// counts the heap allocations done by the calling thread through the global operator new.
+// Useful to check that hot paths (e.g. Animator::UpdateAnimation) don't allocate.
+namespace AllocationCounter {
+	size_t GetThreadAllocations();
+	// bytes requested to operator new by the calling thread, without the overhead of the allocator
+	size_t GetThreadAllocatedBytes();
+}
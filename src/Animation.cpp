@@ -1,11 +1,73 @@
 #include "Animation.h"
+#include "PoseCache.h"
 
+namespace {
+	// collada elements a clip doesn't need: geometry, skinning, materials and the nodes instancing them.
+	// Removing them from the text avoids parsing the whole mesh just to read the keyframes.
+	const char* COLLADA_STRIPPED_ELEMENTS[] = {
+		"library_geometries",
+		"library_controllers",
+		"library_images",
+		"library_materials",
+		"library_effects",
+		"library_cameras",
+		"library_lights",
+		"instance_geometry",
+		"instance_controller",
+		"instance_camera",
+		"instance_light"
+	};
 
-Animation::Animation(const std::string& animationPath, Model& model) : speed(1.0f)
+	// removes every <element ...>...</element> and <element .../> from the xml text
+	std::string StripXmlElement(const std::string& xml, const std::string& element)
+	{
+		std::string result;
+		result.reserve(xml.size());
+		std::string open = "<" + element;
+		std::string close = "</" + element + ">";
+		size_t pos = 0;
+		while (true) {
+			size_t start = xml.find(open, pos);
+			// skip elements whose name only starts with the searched one
+			while (start != std::string::npos && !(std::isspace((unsigned char)xml[start + open.size()]) || xml[start + open.size()] == '>' || xml[start + open.size()] == '/'))
+				start = xml.find(open, start + open.size());
+			if (start == std::string::npos)
+				break;
+			size_t tagEnd = xml.find('>', start);
+			if (tagEnd == std::string::npos)
+				break;
+			size_t end;
+			if (xml[tagEnd - 1] == '/')
+				end = tagEnd + 1;
+			else {
+				end = xml.find(close, tagEnd);
+				if (end == std::string::npos)
+					break;
+				end += close.size();
+			}
+			result.append(xml, pos, start - pos);
+			pos = end;
+		}
+		result.append(xml, pos, std::string::npos);
+		return result;
+	}
+
+	bool EndsWith(const std::string& s, const std::string& suffix)
+	{
+		return s.size() >= suffix.size() && std::equal(suffix.rbegin(), suffix.rend(), s.rbegin(),
+			[](char a, char b) { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); });
+	}
+}
+
+Animation::Animation(const std::string& animationPath, Model& model, const KeyframeCompression& compression) : speed(1.0f)
 {
+	auto importStart = std::chrono::high_resolution_clock::now();
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
+	const aiScene* scene = ImportAnimation(importer, animationPath);
 	assert(scene && scene->mRootNode);
+	aiMemoryInfo memoryInfo;
+	importer.GetMemoryRequirements(memoryInfo);
+	sceneBytes = memoryInfo.total;
 	auto animation = scene->mAnimations[0];
 	int start = animationPath.find_last_of("/") + 1;
 	name = animationPath.substr(start, animationPath.find_last_of(".") - start);
@@ -13,6 +75,44 @@ Animation::Animation(const std::string& animationPath, Model& model) : speed(1.0
 	m_TicksPerSecond = animation->mTicksPerSecond;
 	ReadHeirarchyData(m_RootNode, scene->mRootNode);
 	ReadMissingBones(animation, model);
+	for (Bone& bone : m_Bones)
+	{
+		uncompressedBytes += bone.GetMemoryBytes();
+		if (compression.enabled)
+			bone.Compress(compression);
+		keyframeBytes += bone.GetMemoryBytes();
+	}
+	std::map<std::string, int> channels;
+	for (int i = 0; i < m_Bones.size(); i++)
+		channels.emplace(m_Bones[i].GetBoneName(), i);
+	FlattenHierarchy(m_RootNode, -1, channels);
+	importTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - importStart).count();
+	std::cout << name << ": imported in " << importTime << " ms, parsed " << parsedBytes << "/" << fileBytes
+		<< " bytes, scene " << sceneBytes << " bytes, keyframes " << keyframeBytes << "/" << uncompressedBytes << " bytes\n";
+}
+
+const aiScene* Animation::ImportAnimation(Assimp::Importer& importer, const std::string& animationPath)
+{
+	// whatever survives the parsing, only the hierarchy and the channels are kept
+	importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, aiComponent_MESHES | aiComponent_MATERIALS | aiComponent_TEXTURES
+		| aiComponent_CAMERAS | aiComponent_LIGHTS);
+
+	if (EndsWith(animationPath, ".dae")) {
+		std::ifstream file(animationPath, std::ios::binary);
+		std::string xml((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		fileBytes = xml.size();
+		for (const char* element : COLLADA_STRIPPED_ELEMENTS)
+			xml = StripXmlElement(xml, element);
+		parsedBytes = xml.size();
+		const aiScene* scene = importer.ReadFileFromMemory(xml.data(), xml.size(), aiProcess_RemoveComponent, "dae");
+		if (scene && scene->mRootNode && scene->mNumAnimations > 0)
+			return scene;
+		std::cout << "Lightweight import failed for " << animationPath << ", falling back to the full import\n";
+	}
+
+	const aiScene* scene = importer.ReadFile(animationPath, aiProcess_RemoveComponent);
+	fileBytes = parsedBytes = std::filesystem::exists(animationPath) ? std::filesystem::file_size(animationPath) : 0;
+	return scene;
 }
 
 Bone* Animation::FindBone(const std::string& name)
@@ -27,22 +127,81 @@ Bone* Animation::FindBone(const std::string& name)
 	else return &(*iter);
 }
 
-float Animation::GetTicksPerSecond() { return m_TicksPerSecond; }
-float Animation::GetDuration() { return m_Duration; }
-const AssimpNodeData& Animation::GetRootNode() { return m_RootNode; }
-const std::map<std::string, BoneInfo>& Animation::GetBoneInfoMap() { return m_BoneInfoMap; }
+float Animation::GetTicksPerSecond() const { return m_TicksPerSecond; }
+float Animation::GetDuration() const { return m_Duration; }
+const AssimpNodeData& Animation::GetRootNode() const { return m_RootNode; }
+const std::map<std::string, BoneInfo>& Animation::GetBoneInfoMap() const { return m_BoneInfoMap; }
+const std::vector<AnimationNode>& Animation::GetNodes() const { return m_Nodes; }
+int Animation::GetNumChannels() const { return m_Bones.size(); }
 
-glm::mat4 Animation::GetNodeTransform(const AssimpNodeData* node, float currentTime)
+void Animation::CalculatePose(float currentTime, std::vector<KeyframeCursor>& cursors, std::vector<glm::mat4>& localTransforms, std::vector<glm::mat4>& globalTransforms, std::vector<glm::mat4>& finalBoneMatrices) const
 {
-	auto iter = std::find_if(std::begin(m_Bones), std::end(m_Bones), [&node](const auto& bone) {
-		return bone.GetBoneName() == node->name;
-		});
-	if (iter == std::end(m_Bones))
-		return node->transformation;
-	iter->Update(currentTime);
-	return iter->GetLocalTransform();
+	assert(localTransforms.size() >= m_Nodes.size() && globalTransforms.size() >= m_Nodes.size());
+	assert(cursors.size() >= m_Bones.size());
+	// local pose: sample the channels
+	if (m_Resampled)
+	{
+		for (int i = 0; i < m_Nodes.size(); i++)
+			if (m_Nodes[i].channel < 0)
+				localTransforms[i] = m_Nodes[i].transformation;
+		m_Resampled->Sample(currentTime, localTransforms);
+	}
+	else
+	{
+		for (int i = 0; i < m_Nodes.size(); i++)
+		{
+			const AnimationNode& node = m_Nodes[i];
+			localTransforms[i] = node.channel >= 0 ? m_Bones[node.channel].GetLocalTransform(currentTime, cursors[node.channel]) : node.transformation;
+		}
+	}
+	// global pose: parents come first, so their global transformation is already updated
+	for (int i = 0; i < m_Nodes.size(); i++)
+	{
+		const AnimationNode& node = m_Nodes[i];
+		globalTransforms[i] = node.parent >= 0 ? globalTransforms[node.parent] * localTransforms[i] : localTransforms[i];
+		if (node.boneID >= 0)
+			finalBoneMatrices[node.boneID] = globalTransforms[i] * node.offset;
+	}
+}
+
+void Animation::Resample(float samplesPerSecond)
+{
+	// only the channels bound to a node are sampled
+	std::vector<Bone> bones;
+	std::vector<int> nodes;
+	for (int i = 0; i < m_Nodes.size(); i++)
+	{
+		if (m_Nodes[i].channel < 0)
+			continue;
+		bones.push_back(m_Bones[m_Nodes[i].channel]);
+		nodes.push_back(i);
+	}
+	m_Resampled = std::make_shared<ResampledClip>(bones, nodes, m_Duration, m_TicksPerSecond, samplesPerSecond);
+	std::cout << name << ": resampled " << m_Resampled->GetNumTracks() << " tracks into " << m_Resampled->GetNumFrames()
+		<< " frames (" << m_Resampled->GetMemoryBytes() << " bytes), max error: position " << m_Resampled->maxPositionError
+		<< ", rotation " << m_Resampled->maxRotationError << " deg, scale " << m_Resampled->maxScaleError << "\n";
+}
+
+void Animation::DropResampled()
+{
+	m_Resampled.reset();
+}
+
+const ResampledClip* Animation::GetResampled() const { return m_Resampled.get(); }
+
+void Animation::BuildPoseCache(size_t budgetBytes)
+{
+	m_PoseCache.reset();
+	m_PoseCache = std::make_shared<PoseCache>(*this, budgetBytes);
+}
+
+void Animation::DropPoseCache()
+{
+	m_PoseCache.reset();
 }
 
+const PoseCache* Animation::GetPoseCache() const { return m_PoseCache.get(); }
+
 void Animation::ReadMissingBones(const aiAnimation* animation, Model& model)
 {
 	int size = animation->mNumChannels;
@@ -59,6 +218,29 @@ void Animation::ReadMissingBones(const aiAnimation* animation, Model& model)
 	m_BoneInfoMap = model.GetBoneInfoMap();
 }
 
+void Animation::FlattenHierarchy(const AssimpNodeData& node, int parent, const std::map<std::string, int>& channels)
+{
+	AnimationNode flatNode{};
+	flatNode.transformation = node.transformation;
+	flatNode.offset = glm::mat4(1.0f);
+	flatNode.parent = parent;
+	flatNode.channel = -1;
+	flatNode.boneID = -1;
+	auto channel = channels.find(node.name);
+	if (channel != channels.end())
+		flatNode.channel = channel->second;
+	auto boneInfo = m_BoneInfoMap.find(node.name);
+	if (boneInfo != m_BoneInfoMap.end() && boneInfo->second.id < MAX_NUM_BONE)
+	{
+		flatNode.boneID = boneInfo->second.id;
+		flatNode.offset = boneInfo->second.offset;
+	}
+	int index = m_Nodes.size();
+	m_Nodes.push_back(flatNode);
+	for (const AssimpNodeData& child : node.children)
+		FlattenHierarchy(child, index, channels);
+}
+
 void Animation::ReadHeirarchyData(AssimpNodeData& dest, const aiNode* src)
 {
 	assert(src);
@@ -4,14 +4,23 @@
 #include "BoneInfo.h"
 #include "Model.h"
 #include "AssimpNodeData.h"
+#include "AnimationNode.h"
+#include "ResampledClip.h"
 
 #include <vector>
 #include <map>
 #include <string>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <memory>
 
 #include <glm/glm.hpp>
 #include <assimp/scene.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
 
+class PoseCache;
 
 class Animation
 {
@@ -20,24 +29,54 @@ public:
 	float startFrom = 0.0f; 
 	float endAt;
 	float speed;
+	// import statistics
+	float importTime = 0.0f;
+	size_t fileBytes = 0;
+	// bytes of the file actually parsed by assimp
+	size_t parsedBytes = 0;
+	// memory held by the imported assimp scene
+	size_t sceneBytes = 0;
+	// memory used by the keyframes, before and after the compression
+	size_t uncompressedBytes = 0;
+	size_t keyframeBytes = 0;
 
-	Animation(const std::string& animationPath, Model& model);
+	Animation(const std::string& animationPath, Model& model, const KeyframeCompression& compression = KeyframeCompression());
 
 	Bone* FindBone(const std::string& name);
 
-	float GetTicksPerSecond();
-	float GetDuration();
-	const AssimpNodeData& GetRootNode();
-	const std::map<std::string, BoneInfo>& GetBoneInfoMap();
-	glm::mat4 GetNodeTransform(const AssimpNodeData* node, float currentTime);
+	float GetTicksPerSecond() const;
+	float GetDuration() const;
+	const AssimpNodeData& GetRootNode() const;
+	const std::map<std::string, BoneInfo>& GetBoneInfoMap() const;
+	const std::vector<AnimationNode>& GetNodes() const;
+	int GetNumChannels() const;
+	// evaluates the whole hierarchy at the given time with a pass over the flattened nodes.
+	// The pose buffers must hold at least one matrix per node and the cursors one per channel, the clip is not modified.
+	void CalculatePose(float currentTime, std::vector<KeyframeCursor>& cursors, std::vector<glm::mat4>& localTransforms, std::vector<glm::mat4>& globalTransforms, std::vector<glm::mat4>& finalBoneMatrices) const;
+	// samples the channels from tracks resampled at a fixed rate instead of the original keys
+	void Resample(float samplesPerSecond = RESAMPLE_RATE);
+	void DropResampled();
+	const ResampledClip* GetResampled() const;
+	// precomputes the final bone matrices on a background thread, see PoseCache
+	void BuildPoseCache(size_t budgetBytes);
+	void DropPoseCache();
+	const PoseCache* GetPoseCache() const;
 
 private:
+	// imports only the skeleton and the channels of the clip
+	const aiScene* ImportAnimation(Assimp::Importer& importer, const std::string& animationPath);
 	void ReadMissingBones(const aiAnimation* animation, Model& model);
 	void ReadHeirarchyData(AssimpNodeData& dest, const aiNode* src);
+	// binds every node to its channel and its bone once, so the pose evaluation doesn't need names
+	void FlattenHierarchy(const AssimpNodeData& node, int parent, const std::map<std::string, int>& channels);
 
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	std::vector<AnimationNode> m_Nodes;
+	// shared by the copies of the clip, it is never modified after being built
+	std::shared_ptr<const ResampledClip> m_Resampled;
+	std::shared_ptr<const PoseCache> m_PoseCache;
 };
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// node of a hierarchy flattened in depth-first order, so every parent comes before its children
+struct AnimationNode
+{
+	glm::mat4 transformation;
+	/*offset matrix of the bone associated to the node*/
+	glm::mat4 offset;
+	/*index of the parent in the flattened hierarchy, -1 for the root*/
+	int parent;
+	/*index of the channel animating the node, -1 if the node is not animated*/
+	int channel;
+	/*index in finalBoneMatrices, -1 if the node is not a bone*/
+	int boneID;
+};
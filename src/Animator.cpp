@@ -8,13 +8,32 @@ Animator::Animator() : m_CurrentTime(0.0f), currentAnimationIndex(0), m_FinalBon
 
 void Animator::UpdateAnimation(float dt)
 {
-	Animation currentAnimation = animations[currentAnimationIndex];
-	if (&currentAnimation)
+	size_t allocationsBefore = AllocationCounter::GetThreadAllocations();
+	const Animation& currentAnimation = animations[currentAnimationIndex];
+	float previousTime = m_CurrentTime;
+	m_CurrentTime += currentAnimation.GetTicksPerSecond() * dt * currentAnimation.speed;
+	m_CurrentTime = std::clamp(fmod(m_CurrentTime,currentAnimation.endAt), currentAnimation.startFrom, currentAnimation.endAt);
+	// the buffers are already big enough unless the animations were modified from outside
+	ReservePoseBuffers(currentAnimation);
+	// the animation looped: the cursors would be after the new time
+	if (m_CurrentTime < previousTime && dt > 0.0f)
+		ResetCursors();
+	currentAnimation.CalculatePose(m_CurrentTime, m_Cursors, m_LocalTransforms, m_GlobalTransforms, m_FinalBoneMatrices);
+	m_LastUpdateAllocations = AllocationCounter::GetThreadAllocations() - allocationsBefore;
+}
+
+void Animator::SetTime(float time)
+{
+	m_CurrentTime = time;
+	const PoseCache* cache = usePoseCache ? animations[currentAnimationIndex].GetPoseCache() : nullptr;
+	if (cache && cache->Sample(time, blendPoseCache, m_FinalBoneMatrices))
 	{
-		m_CurrentTime += currentAnimation.GetTicksPerSecond() * dt * currentAnimation.speed;
-		m_CurrentTime = std::clamp(fmod(m_CurrentTime,currentAnimation.endAt), currentAnimation.startFrom, currentAnimation.endAt);
-		CalculateBoneTransform(&currentAnimation.GetRootNode(), glm::mat4(1.0f));
+		m_PoseCacheHits++;
+		return;
 	}
+	if (usePoseCache)
+		m_PoseCacheMisses++;
+	UpdateAnimation(0.0f);
 }
 
 void Animator::PlayAnimation(Animation* animation)
@@ -23,6 +42,8 @@ void Animator::PlayAnimation(Animation* animation)
 		currentAnimationIndex = animations.size();
 		AddAnimation(*animation);
 		m_CurrentTime = 0.0f;
+		ResetCursors();
+		PreparePoseCache();
 	}
 }
 
@@ -30,6 +51,8 @@ void Animator::PlayAnimationIndex(int index)
 {
 	currentAnimationIndex = (index + animations.size()) % animations.size();
 	m_CurrentTime = 0.0f;
+	ResetCursors();
+	PreparePoseCache();
 }
 
 void Animator::PlayNextAnimation()
@@ -42,35 +65,89 @@ void Animator::PlayPrevAnimation()
 	PlayAnimationIndex(currentAnimationIndex - 1);
 }
 
-void Animator::CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
-{ // Worth farla iterativa?
-	std::string nodeName = node->name;
-	Animation currentAnimation = animations[currentAnimationIndex];
-	glm::mat4 nodeTransform = currentAnimation.GetNodeTransform(node, m_CurrentTime);
+std::vector<glm::mat4>& Animator::GetFinalBoneMatrices()
+{
+	return m_FinalBoneMatrices;
+}
 
-	glm::mat4 globalTransformation = parentTransform * nodeTransform;
+const Animation& Animator::GetCurrentAnimation() const
+{
+	return animations[currentAnimationIndex];
+}
+
+void Animator::AddAnimation(Animation animation)
+{
+	ReservePoseBuffers(animation);
+	if (useResampledTracks && !animation.GetResampled())
+		animation.Resample();
+	animations.push_back(std::move(animation));
+}
+
+void Animator::SetAnimations(std::vector<Animation>&& newAnimations)
+{
+	animations = std::move(newAnimations);
+	currentAnimationIndex = 0;
+	m_CurrentTime = 0.0f;
+	for (const Animation& animation : animations)
+		ReservePoseBuffers(animation);
+	ResetCursors();
+	SetUseResampledTracks(useResampledTracks);
+	PreparePoseCache();
+}
 
-	auto boneInfoMap = currentAnimation.GetBoneInfoMap();
-	if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+void Animator::SetUseResampledTracks(bool use)
+{
+	useResampledTracks = use;
+	for (Animation& animation : animations)
 	{
-		int index = boneInfoMap[nodeName].id;
-		glm::mat4 offset = boneInfoMap[nodeName].offset;
-		m_FinalBoneMatrices[index] = globalTransformation * offset;
+		if (!use)
+			animation.DropResampled();
+		else if (!animation.GetResampled())
+			animation.Resample();
 	}
+	ResetCursors();
+}
 
-	for (int i = 0; i < node->childrenCount; i++)
-		CalculateBoneTransform(&node->children[i], globalTransformation);
+void Animator::SetUsePoseCache(bool use)
+{
+	usePoseCache = use;
+	m_PoseCacheHits = m_PoseCacheMisses = 0;
+	if (use)
+		PreparePoseCache();
+	else
+		for (Animation& animation : animations)
+			animation.DropPoseCache();
 }
 
-std::vector<glm::mat4>& Animator::GetFinalBoneMatrices()
+float Animator::GetPoseCacheHitRate() const
 {
-	return m_FinalBoneMatrices;
+	int total = m_PoseCacheHits + m_PoseCacheMisses;
+	return total > 0 ? float(m_PoseCacheHits) / total : 0.0f;
 }
 
-void Animator::AddAnimation(Animation animation)
+void Animator::PreparePoseCache()
 {
-	if (&animation)
-	{
-		animations.push_back(animation);
-	}
+	if (usePoseCache && !animations.empty() && !animations[currentAnimationIndex].GetPoseCache())
+		animations[currentAnimationIndex].BuildPoseCache(poseCacheBudget);
+}
+
+size_t Animator::GetLastUpdateAllocations() const
+{
+	return m_LastUpdateAllocations;
+}
+
+void Animator::ReservePoseBuffers(const Animation& animation)
+{
+	size_t numNodes = animation.GetNodes().size();
+	if (m_LocalTransforms.size() < numNodes)
+		m_LocalTransforms.resize(numNodes);
+	if (m_GlobalTransforms.size() < numNodes)
+		m_GlobalTransforms.resize(numNodes);
+	if (m_Cursors.size() < animation.GetNumChannels())
+		m_Cursors.resize(animation.GetNumChannels());
+}
+
+void Animator::ResetCursors()
+{
+	std::fill(m_Cursors.begin(), m_Cursors.end(), KeyframeCursor());
 }
@@ -2,6 +2,8 @@
 
 #include "Animation.h"
 #include "Bone.h"
+#include "AllocationCounter.h"
+#include "PoseCache.h"
 
 #include <map>
 #include <vector>
@@ -18,18 +20,51 @@ public:
 	float m_CurrentTime;
 	std::vector<Animation> animations;
 	int currentAnimationIndex = 0;
+	// sample the animations from tracks resampled at a fixed rate
+	bool useResampledTracks = false;
+	// scrub the current animation through its cached palettes
+	bool usePoseCache = false;
+	// blend the two closest cached palettes instead of taking the nearest one
+	bool blendPoseCache = true;
+	size_t poseCacheBudget = POSE_CACHE_BUDGET;
 
 	Animator();
+	// advances the current animation and updates the final bone matrices. It doesn't allocate memory.
 	void UpdateAnimation(float dt);
+	// moves the current animation to the given time, from the pose cache when possible
+	void SetTime(float time);
 	void PlayAnimation(Animation* animation);
 	void PlayAnimationIndex(int index);
 	void PlayNextAnimation();
 	void PlayPrevAnimation();
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform);
 	std::vector<glm::mat4>& GetFinalBoneMatrices();
+	const Animation& GetCurrentAnimation() const;
 	void AddAnimation(Animation animation);
+	// replaces all the animations
+	void SetAnimations(std::vector<Animation>&& newAnimations);
+	void SetUseResampledTracks(bool use);
+	void SetUsePoseCache(bool use);
+	// fraction of the SetTime calls served by the pose cache
+	float GetPoseCacheHitRate() const;
+	// heap allocations done by the last call of UpdateAnimation
+	size_t GetLastUpdateAllocations() const;
 
 private:
 	std::vector<glm::mat4> m_FinalBoneMatrices;
+	// local and global transformation of each node of the current animation.
+	// They are sized for the biggest hierarchy when animations are added.
+	std::vector<glm::mat4> m_LocalTransforms;
+	std::vector<glm::mat4> m_GlobalTransforms;
+	// keyframe cursor of each channel of the current animation
+	std::vector<KeyframeCursor> m_Cursors;
+	size_t m_LastUpdateAllocations = 0;
+	int m_PoseCacheHits = 0;
+	int m_PoseCacheMisses = 0;
+
+	void ReservePoseBuffers(const Animation& animation);
+	// restarts the keyframe search from the first keys
+	void ResetCursors();
+	// builds the pose cache of the current animation if it is enabled and missing
+	void PreparePoseCache();
 };
 
@@ -0,0 +1,96 @@
+#include "BakedModel.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+void BakedMesh::Prepare(Mesh& animatedMesh)
+{
+	mesh = &animatedMesh;
+	positions.resize(animatedMesh.vertices.size());
+	normals.resize(animatedMesh.vertices.size());
+	weightMatrices.resize(animatedMesh.vertices.size());
+	inverseWeightMatrices.resize(animatedMesh.vertices.size());
+}
+
+void BakedMesh::BakeRange(std::vector<glm::mat4>& matrices, int begin, int end, SkinningPath path)
+{
+	// streams of a chunk, reused by each thread across chunks and bakes
+	static thread_local SkinningInput input;
+	static thread_local SkinningOutput output;
+	input.Load(mesh->vertices, begin, end);
+	output.Resize(end - begin);
+	SkinVertices(input, matrices, output, &weightMatrices[begin], 0, end - begin, path);
+	InvertBlendedMatrices(&weightMatrices[begin], &inverseWeightMatrices[begin], end - begin, path);
+	for (int i = begin; i < end; i++) {
+		int j = i - begin;
+		positions[i] = glm::vec3(output.px[j], output.py[j], output.pz[j]);
+		normals[i] = glm::vec3(output.nx[j], output.ny[j], output.nz[j]);
+	}
+}
+
+void BakedMesh::BuildBVH()
+{
+	bvh.Build(positions, GetFaces());
+}
+
+size_t BakedMesh::GetMemoryBytes() const
+{
+	return positions.size() * sizeof(glm::vec3) + normals.size() * sizeof(glm::vec3) + weightMatrices.size() * sizeof(glm::mat4)
+		+ inverseWeightMatrices.size() * sizeof(glm::mat3);
+}
+
+size_t BakedModel::GetMemoryBytes() const
+{
+	size_t bytes = 0;
+	for (const BakedMesh& m : meshes)
+		bytes += m.GetMemoryBytes();
+	return bytes;
+}
+
+void BakedModel::BuildBVHs()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	ThreadPool::Instance().ParallelFor(meshes.size(), [&](int i) {
+		meshes[i].BuildBVH();
+		});
+	bvhBuildTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void BakedModel::RefitBVHs()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	// every refit is parallel over the nodes of a level
+	for (BakedMesh& m : meshes)
+		m.bvh.Refit(m.positions, m.GetFaces());
+	bvhRefitTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+BVHUpdateTiming BakedModel::BenchmarkBVHUpdate()
+{
+	constexpr int NUM_RUNS = 5;
+	BVHUpdateTiming timing;
+	for (const BakedMesh& m : meshes)
+		timing.numTriangles += m.GetFaces().size();
+	timing.refitTime = timing.rebuildTime = FLT_MAX;
+	for (int run = 0; run < NUM_RUNS; run++) {
+		RefitBVHs();
+		timing.refitTime = std::min(timing.refitTime, bvhRefitTime);
+	}
+	for (int run = 0; run < NUM_RUNS; run++) {
+		BuildBVHs();
+		timing.rebuildTime = std::min(timing.rebuildTime, bvhBuildTime);
+	}
+	std::cout << "BVH update of " << timing.numTriangles << " triangles: refit " << timing.refitTime << " ms, rebuild "
+		<< timing.rebuildTime << " ms\n";
+	return timing;
+}
+
+size_t BakedModel::GetBVHMemoryBytes() const
+{
+	size_t bytes = 0;
+	for (const BakedMesh& m : meshes)
+		bytes += m.bvh.GetMemoryBytes();
+	return bytes;
+}
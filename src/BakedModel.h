@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Mesh.h"
+#include "SkinningKernel.h"
+#include "MeshBVH.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// vertices skinned by a single baking task
+constexpr int BAKE_CHUNK_SIZE = 16384;
+
+// pose of an animated mesh skinned on the cpu, used to pick and edit the vertices while the animation is paused.
+// It only holds the skinned positions and normals: the faces, the adjacency and the vertices edited through
+// the pose are the ones of the animated mesh, which must outlive it.
+struct BakedMesh {
+	Mesh* mesh = nullptr;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	// matrix that skinned each vertex
+	std::vector<glm::mat4> weightMatrices;
+	// inverse of its linear part, to bring the offsets of the edits back to the bind pose
+	std::vector<glm::mat3> inverseWeightMatrices;
+	// hierarchy over the baked triangles to pick them
+	MeshBVH bvh;
+
+	const std::vector<Face>& GetFaces() const { return mesh->faces; }
+	// animated vertex the baked vertex comes from
+	Vertex& GetOriginalVertex(int index) const { return mesh->vertices[index]; }
+	// sizes the pose for the vertices of the animated mesh, to fill with BakeRange
+	void Prepare(Mesh& animatedMesh);
+	// bakes the vertices [begin, end). Different ranges can be baked in parallel.
+	void BakeRange(std::vector<glm::mat4>& matrices, int begin, int end, SkinningPath path);
+	void BuildBVH();
+	size_t GetMemoryBytes() const;
+};
+
+struct BVHUpdateTiming {
+	int numTriangles = 0;
+	// time to refit or rebuild the hierarchies of all the meshes (ms)
+	float refitTime = 0.0f;
+	float rebuildTime = 0.0f;
+};
+
+struct BakedModel {
+	std::vector<BakedMesh> meshes;
+	// time spent baking (ms)
+	float bakeTime = 0.0f;
+	// time spent building the hierarchies of all the meshes (ms)
+	float bvhBuildTime = 0.0f;
+	// time spent by the last refit of all the meshes (ms)
+	float bvhRefitTime = 0.0f;
+
+	// builds the hierarchies of the meshes in parallel, once the pose is baked
+	void BuildBVHs();
+	// updates the hierarchies for a new pose baked into the same meshes
+	void RefitBVHs();
+	// refits and rebuilds the hierarchies of the current pose, the best of a few runs each
+	BVHUpdateTiming BenchmarkBVHUpdate();
+	size_t GetMemoryBytes() const;
+	size_t GetBVHMemoryBytes() const;
+};
@@ -1,10 +1,12 @@
 #include  "Bone.h"
 
+#include <algorithm>
+#include <climits>
+
 Bone::Bone(const std::string& name, int ID, const aiNodeAnim* channel)
 	:
 	m_Name(name),
 	m_ID(ID),
-	m_LocalTransform(1.0f),
 	m_NumPositions(channel->mNumPositionKeys),
 	m_NumRotations(channel->mNumRotationKeys),
 	m_NumScalings(channel->mNumScalingKeys)
@@ -40,101 +42,195 @@ Bone::Bone(const std::string& name, int ID, const aiNodeAnim* channel)
 	}
 }
 
-void Bone::Update(float animationTime)
+glm::mat4 Bone::GetLocalTransform(float animationTime, KeyframeCursor& cursor) const
 {
-	glm::mat4 translation = InterpolatePosition(animationTime);
-	glm::mat4 rotation = InterpolateRotation(animationTime);
-	glm::mat4 scale = InterpolateScaling(animationTime);
-	m_LocalTransform = translation * rotation * scale;
+	glm::mat4 translation = glm::translate(glm::mat4(1.0f), InterpolatePosition(animationTime, cursor.position));
+	glm::mat4 rotation = glm::toMat4(InterpolateRotation(animationTime, cursor.rotation));
+	glm::mat4 scale = glm::scale(glm::mat4(1.0f), InterpolateScaling(animationTime, cursor.scale));
+	return translation * rotation * scale;
 }
 
-glm::mat4 Bone::GetLocalTransform() { return m_LocalTransform; }
-std::string Bone::GetBoneName() const { return m_Name; }
-int Bone::GetBoneID() { return m_ID; }
+glm::mat4 Bone::GetLocalTransform(float animationTime) const
+{
+	// a cursor far from the keys makes every track use the binary search
+	KeyframeCursor cursor{ INT_MAX, INT_MAX, INT_MAX };
+	return GetLocalTransform(animationTime, cursor);
+}
 
-int Bone::GetPositionIndex(float animationTime)
+void Bone::GetLocalPose(float animationTime, KeyframeCursor& cursor, glm::vec3& position, glm::quat& rotation, glm::vec3& scale) const
 {
-	for (int index = 1; index < m_NumPositions; ++index)
-	{
-		if (animationTime < m_Positions[index].timeStamp)
-			return index - 1;
-	}
-	assert(0);
+	position = InterpolatePosition(animationTime, cursor.position);
+	rotation = InterpolateRotation(animationTime, cursor.rotation);
+	scale = InterpolateScaling(animationTime, cursor.scale);
+}
+
+const std::string& Bone::GetBoneName() const { return m_Name; }
+int Bone::GetBoneID() const { return m_ID; }
+const std::vector<KeyPosition>& Bone::GetPositions() const { return m_Positions; }
+const std::vector<KeyScale>& Bone::GetScales() const { return m_Scales; }
+int Bone::GetNumRotationKeys() const { return m_NumRotations; }
+
+float Bone::GetRotationTime(int index) const
+{
+	return m_PackedRotations.empty() ? m_Rotations[index].timeStamp : m_PackedRotations[index].timeStamp;
+}
+
+glm::quat Bone::GetRotation(int index) const
+{
+	return m_PackedRotations.empty() ? m_Rotations[index].orientation : UnpackQuat(m_PackedRotations[index].orientation);
 }
 
-int Bone::GetRotationIndex(float animationTime)
+void Bone::Compress(const KeyframeCompression& compression)
 {
-	for (int index = 1; index < m_NumRotations; ++index)
+	auto positionError = [](const KeyPosition& a, const KeyPosition& b) { return glm::length(a.position - b.position); };
+	auto lerpPosition = [](const KeyPosition& a, const KeyPosition& b, float factor) { return KeyPosition{ glm::mix(a.position, b.position, factor), 0.0f }; };
+	ReduceKeys(m_Positions, compression.positionTolerance, lerpPosition, positionError);
+
+	// same interpolation used when sampling
+	auto rotationError = [](const KeyRotation& a, const KeyRotation& b) { return GetAngleDegrees(a.orientation, b.orientation); };
+	auto lerpRotation = [](const KeyRotation& a, const KeyRotation& b, float factor) { return KeyRotation{ glm::slerp(a.orientation, b.orientation, factor), 0.0f }; };
+	if (m_PackedRotations.empty())
+		ReduceKeys(m_Rotations, compression.rotationTolerance, lerpRotation, rotationError);
+
+	auto scaleError = [](const KeyScale& a, const KeyScale& b) { return glm::length(a.scale - b.scale); };
+	auto lerpScale = [](const KeyScale& a, const KeyScale& b, float factor) { return KeyScale{ glm::mix(a.scale, b.scale, factor), 0.0f }; };
+	ReduceKeys(m_Scales, compression.scaleTolerance, lerpScale, scaleError);
+
+	if (compression.quantizeRotations && !m_Rotations.empty())
 	{
-		if (animationTime < m_Rotations[index].timeStamp)
-			return index - 1;
+		m_PackedRotations.reserve(m_Rotations.size());
+		for (const KeyRotation& key : m_Rotations)
+			m_PackedRotations.push_back({ PackQuat(key.orientation), key.timeStamp });
+		m_Rotations.clear();
+		m_Rotations.shrink_to_fit();
 	}
-	assert(0);
+	m_Positions.shrink_to_fit();
+	m_Scales.shrink_to_fit();
+	m_NumPositions = m_Positions.size();
+	m_NumRotations = m_PackedRotations.empty() ? m_Rotations.size() : m_PackedRotations.size();
+	m_NumScalings = m_Scales.size();
 }
 
-int Bone::GetScaleIndex(float animationTime)
+size_t Bone::GetMemoryBytes() const
 {
-	for (int index = 1; index < m_NumScalings; ++index)
+	return m_Positions.capacity() * sizeof(KeyPosition) + m_Rotations.capacity() * sizeof(KeyRotation)
+		+ m_PackedRotations.capacity() * sizeof(PackedKeyRotation) + m_Scales.capacity() * sizeof(KeyScale);
+}
+
+namespace {
+	// keys checked after the cursor before falling back to the binary search
+	constexpr int MAX_CURSOR_STEPS = 4;
+
+	// index i of the segment [keys[i], keys[i + 1]] containing the time, clamped to the first and last segment
+	template<typename Key>
+	int FindKeyIndex(const std::vector<Key>& keys, float animationTime, int& cursor)
 	{
-		if (animationTime < m_Scales[index].timeStamp)
-			return index - 1;
+		int last = int(keys.size()) - 2;
+		if (last <= 0)
+			return cursor = 0;
+		int index = cursor;
+		if (index >= 0 && index <= last && keys[index].timeStamp <= animationTime)
+		{
+			// forward playback: the time moved of a few keys at most
+			for (int steps = 0; index < last && keys[index + 1].timeStamp <= animationTime; steps++, index++)
+			{
+				if (steps == MAX_CURSOR_STEPS)
+				{
+					index = -1;
+					break;
+				}
+			}
+			if (index >= 0)
+				return cursor = index;
+		}
+		// scrubbing or looping: search the whole track
+		auto next = std::upper_bound(keys.begin() + 1, keys.end() - 1, animationTime,
+			[](float time, const Key& key) { return time < key.timeStamp; });
+		return cursor = int(next - keys.begin()) - 1;
 	}
-	assert(0);
 }
 
-float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+int Bone::GetPositionIndex(float animationTime) const
+{
+	int cursor = -1;
+	return FindKeyIndex(m_Positions, animationTime, cursor);
+}
+
+int Bone::GetRotationIndex(float animationTime) const
+{
+	int cursor = -1;
+	return GetRotationIndex(animationTime, cursor);
+}
+
+int Bone::GetScaleIndex(float animationTime) const
+{
+	int cursor = -1;
+	return FindKeyIndex(m_Scales, animationTime, cursor);
+}
+
+int Bone::GetPositionIndex(float animationTime, int& cursor) const
+{
+	return FindKeyIndex(m_Positions, animationTime, cursor);
+}
+
+int Bone::GetRotationIndex(float animationTime, int& cursor) const
+{
+	if (!m_PackedRotations.empty())
+		return FindKeyIndex(m_PackedRotations, animationTime, cursor);
+	return FindKeyIndex(m_Rotations, animationTime, cursor);
+}
+
+int Bone::GetScaleIndex(float animationTime, int& cursor) const
+{
+	return FindKeyIndex(m_Scales, animationTime, cursor);
+}
+
+float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const
 {
 	float scaleFactor = 0.0f;
 	float midWayLength = animationTime - lastTimeStamp;
 	float framesDiff = nextTimeStamp - lastTimeStamp;
 	scaleFactor = midWayLength / framesDiff;
-	return scaleFactor;
+	// times before the first key or after the last one hold the pose of the key
+	return glm::clamp(scaleFactor, 0.0f, 1.0f);
 }
 
-glm::mat4 Bone::InterpolatePosition(float animationTime)
+glm::vec3 Bone::InterpolatePosition(float animationTime, int& cursor) const
 {
 	if (1 == m_NumPositions)
-		return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
+		return m_Positions[0].position;
 
-	int p0Index = GetPositionIndex(animationTime);
+	int p0Index = GetPositionIndex(animationTime, cursor);
 	int p1Index = p0Index + 1;
 	float scaleFactor = GetScaleFactor(m_Positions[p0Index].timeStamp,
 		m_Positions[p1Index].timeStamp, animationTime);
-	glm::vec3 finalPosition = glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
+	return glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
 		, scaleFactor);
-	return glm::translate(glm::mat4(1.0f), finalPosition);
 }
 
-glm::mat4 Bone::InterpolateRotation(float animationTime)
+glm::quat Bone::InterpolateRotation(float animationTime, int& cursor) const
 {
 	if (1 == m_NumRotations)
-	{
-		auto rotation = glm::normalize(m_Rotations[0].orientation);
-		return glm::toMat4(rotation);
-	}
+		return glm::normalize(GetRotation(0));
 
-	int p0Index = GetRotationIndex(animationTime);
+	int p0Index = GetRotationIndex(animationTime, cursor);
 	int p1Index = p0Index + 1;
-	float scaleFactor = GetScaleFactor(m_Rotations[p0Index].timeStamp,
-		m_Rotations[p1Index].timeStamp, animationTime);
-	glm::quat finalRotation = glm::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation
+	float scaleFactor = GetScaleFactor(GetRotationTime(p0Index),
+		GetRotationTime(p1Index), animationTime);
+	glm::quat finalRotation = glm::slerp(GetRotation(p0Index), GetRotation(p1Index)
 		, scaleFactor);
-	finalRotation = glm::normalize(finalRotation);
-	return glm::toMat4(finalRotation);
-
+	return glm::normalize(finalRotation);
 }
 
-glm::mat4 Bone::InterpolateScaling(float animationTime)
+glm::vec3 Bone::InterpolateScaling(float animationTime, int& cursor) const
 {
 	if (1 == m_NumScalings)
-		return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
+		return m_Scales[0].scale;
 
-	int p0Index = GetScaleIndex(animationTime);
+	int p0Index = GetScaleIndex(animationTime, cursor);
 	int p1Index = p0Index + 1;
 	float scaleFactor = GetScaleFactor(m_Scales[p0Index].timeStamp,
 		m_Scales[p1Index].timeStamp, animationTime);
-	glm::vec3 finalScale = glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
+	return glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
 		, scaleFactor);
-	return glm::scale(glm::mat4(1.0f), finalScale);
 }
-
@@ -3,6 +3,7 @@
 /* Container for bone data */
 
 #include "assimp_glm_helpers.h"
+#include "KeyframeCompression.h"
 
 #include <vector>
 #include <list>
@@ -25,40 +26,76 @@ struct KeyRotation
 	float timeStamp;
 };
 
+// rotation key quantized to 48 bits
+struct PackedKeyRotation
+{
+	PackedQuat orientation;
+	float timeStamp;
+};
+
 struct KeyScale
 {
 	glm::vec3 scale;
 	float timeStamp;
 };
 
+// last key used by each track of a bone. Kept by whoever plays the clip, so during
+// forward playback the next key is found in a step instead of scanning the track.
+struct KeyframeCursor
+{
+	int position = 0;
+	int rotation = 0;
+	int scale = 0;
+};
+
 class Bone
 {
 public:
 	Bone(const std::string& name, int ID, const aiNodeAnim* channel);
-	void Update(float animationTime);
-	glm::mat4 GetLocalTransform();
-	std::string GetBoneName() const;
-	int GetBoneID();
-	int GetPositionIndex(float animationTime);
-	int GetRotationIndex(float animationTime);
-	int GetScaleIndex(float animationTime);
+	// samples the channel at the given time. The bone is not modified, so clips can be shared.
+	// The cursor is moved forward from the last sampled keys, or searched again when the time goes back.
+	glm::mat4 GetLocalTransform(float animationTime, KeyframeCursor& cursor) const;
+	glm::mat4 GetLocalTransform(float animationTime) const;
+	// same as GetLocalTransform, without composing the matrix
+	void GetLocalPose(float animationTime, KeyframeCursor& cursor, glm::vec3& position, glm::quat& rotation, glm::vec3& scale) const;
+	const std::string& GetBoneName() const;
+	int GetBoneID() const;
+	// index of the key starting the segment containing animationTime (binary search)
+	int GetPositionIndex(float animationTime) const;
+	int GetRotationIndex(float animationTime) const;
+	int GetScaleIndex(float animationTime) const;
+	// same as above starting from the cursor, which is updated
+	int GetPositionIndex(float animationTime, int& cursor) const;
+	int GetRotationIndex(float animationTime, int& cursor) const;
+	int GetScaleIndex(float animationTime, int& cursor) const;
+	const std::vector<KeyPosition>& GetPositions() const;
+	// the rotation keys are stored either in full precision or quantized
+	int GetNumRotationKeys() const;
+	float GetRotationTime(int index) const;
+	glm::quat GetRotation(int index) const;
+	const std::vector<KeyScale>& GetScales() const;
+	// removes the keys within the tolerances and quantizes the rotations
+	void Compress(const KeyframeCompression& compression);
+	// memory used by the keys
+	size_t GetMemoryBytes() const;
 
 
 private:
 
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime);
-	glm::mat4 InterpolatePosition(float animationTime);
-	glm::mat4 InterpolateRotation(float animationTime);
-	glm::mat4 InterpolateScaling(float animationTime);
+	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const;
+	glm::vec3 InterpolatePosition(float animationTime, int& cursor) const;
+	glm::quat InterpolateRotation(float animationTime, int& cursor) const;
+	glm::vec3 InterpolateScaling(float animationTime, int& cursor) const;
 
 	std::vector<KeyPosition> m_Positions;
 	std::vector<KeyRotation> m_Rotations;
+	// replaces m_Rotations when the rotations are quantized
+	std::vector<PackedKeyRotation> m_PackedRotations;
 	std::vector<KeyScale> m_Scales;
 	int m_NumPositions;
 	int m_NumRotations;
 	int m_NumScalings;
 
-	glm::mat4 m_LocalTransform;
 	std::string m_Name;
 	int m_ID;
 };
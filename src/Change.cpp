@@ -1,26 +1,42 @@
 #include "Change.h"
 #include "eigen_glm_helpers.h"
+#include "SkinningKernel.h"
+#include "ThreadPool.h"
 
-Change::Change(std::vector<Vertex*>& changedVertices)
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+
+Change::Change(const std::vector<ChangedVertex>& changedVertices)
 	:
 	changedVertices(changedVertices),
 	offset(glm::vec3(0.0f, 0.0f, 0.0f))
 {}
 
-void Change::Apply() {
-	for (auto&& v : changedVertices) {
-		v->Position += offset;
-		glm::mat4 inverse = glm::inverse(v->associatedWeightMatrix);
-		v->originalVertex->Position += glm::vec3((inverse * glm::vec4(offset, 0.0f)));
-	}
+void Change::Apply(unsigned int numThreads) {
+	Move(offset, numThreads);
 }
 
-void Change::Undo() {
-	for (auto&& v : changedVertices) {
-		v->Position -= offset;
-		glm::mat4 inverse = glm::inverse(v->associatedWeightMatrix);
-		v->originalVertex->Position -= glm::vec3((inverse * glm::vec4(offset, 0.0f)));
-	}
+void Change::Undo(unsigned int numThreads) {
+	Move(-offset, numThreads);
+}
+
+void Change::Move(glm::vec3 delta, unsigned int numThreads)
+{
+	int numChunks = (int(changedVertices.size()) + CHANGE_CHUNK_SIZE - 1) / CHANGE_CHUNK_SIZE;
+	ThreadPool::Instance().ParallelFor(numChunks, [&](int chunk) {
+		int end = std::min<int>((chunk + 1) * CHANGE_CHUNK_SIZE, changedVertices.size());
+		for (int i = chunk * CHANGE_CHUNK_SIZE; i < end; i++) {
+			ChangedVertex& v = changedVertices[i];
+			*v.position += delta;
+			v.originalVertex->Position += v.inverseWeightMatrix * delta;
+		}
+		}, numThreads);
+	// the dirty lists of the meshes are not shared between threads
+	for (ChangedVertex& v : changedVertices)
+		v.mesh->MarkDirty(v.vertexIndex);
 }
 
 void Change::Modify(glm::vec3 newoffset)
@@ -31,24 +47,203 @@ void Change::Modify(glm::vec3 newoffset)
 }
 
 
-void Change::Reskin(std::vector<glm::mat4>& matrices) {
-	for (auto&& v : changedVertices) {
-		std::vector<glm::vec3> positions(matrices.size());
-		for (int i = 0; i < matrices.size(); i++) {
-			positions.push_back(glm::vec3(matrices[i] * glm::vec4(v->originalVertex->Position, 1.0f)));
+ReskinStats Change::Reskin(const std::vector<glm::mat4>& matrices, const ReskinOptions& options, unsigned int numThreads)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<float> residuals(changedVertices.size(), 0.0f);
+	int numChunks = (int(changedVertices.size()) + CHANGE_CHUNK_SIZE - 1) / CHANGE_CHUNK_SIZE;
+	ThreadPool::Instance().ParallelFor(numChunks, [&](int chunk) {
+		int end = std::min<int>((chunk + 1) * CHANGE_CHUNK_SIZE, changedVertices.size());
+		for (int i = chunk * CHANGE_CHUNK_SIZE; i < end; i++) {
+			ChangedVertex& v = changedVertices[i];
+			VertexBoneData& bones = v.originalVertex->BoneData;
+			if (bones.NumBones == 0)
+				continue;
+			glm::vec3 bindPosition = v.originalVertex->Position - v.inverseWeightMatrix * offset;
+			// only the bones already influencing the vertex, or reached by the propagation, are candidates
+			glm::vec3 candidates[MAX_BONE_INFLUENCE];
+			for (int k = 0; k < bones.NumBones; k++)
+				candidates[k] = glm::vec3(matrices[bones.BoneIDs[k]] * glm::vec4(bindPosition, 1.0f));
+			float weights[MAX_BONE_INFLUENCE];
+			residuals[i] = SolveSkinningWeights(candidates, bones.NumBones, *v.position, options, weights);
+
+			int order[MAX_BONE_INFLUENCE];
+			std::iota(order, order + bones.NumBones, 0);
+			std::stable_sort(order, order + bones.NumBones, [&](int a, int b) { return weights[a] > weights[b]; });
+			int boneIDs[MAX_BONE_INFLUENCE];
+			std::copy(bones.BoneIDs, bones.BoneIDs + bones.NumBones, boneIDs);
+			// the bones with no weight are kept as candidates of the next edits
+			for (int k = 0; k < bones.NumBones; k++) {
+				bones.BoneIDs[k] = boneIDs[order[k]];
+				bones.Weights[k] = weights[order[k]];
+			}
+			v.originalVertex->Position = bindPosition;
 		}
-		Eigen::MatrixXf mat = MakeEigenMatrixWithGLMVec3Cols(positions);
-		Eigen::Vector3f finalPos = ConvertGLMVec3ToEigenVec3(v->Position);
-		Eigen::VectorXf weights = mat.colPivHouseholderQr().solve(finalPos);
-
-		Vertex* original = v->originalVertex;
-		original->BoneData.NumBones = 0;
-		for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
-			if (weights(i) > FLT_EPSILON || weights(i) < -FLT_EPSILON) //!= 0 for floating point values
-			{
-				original->BoneData.BoneIDs[original->BoneData.NumBones] = i;
-				original->BoneData.Weights[original->BoneData.NumBones++] = weights(i);
+		}, numThreads);
+	for (ChangedVertex& v : changedVertices)
+		v.mesh->MarkDirty(v.vertexIndex);
+
+	ReskinStats stats;
+	stats.numVertices = int(changedVertices.size());
+	stats.time = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	stats.verticesPerSecond = stats.numVertices / (stats.time / 1000.0);
+	for (float residual : residuals) {
+		stats.meanResidual += residual;
+		stats.maxResidual = std::max(stats.maxResidual, residual);
+	}
+	if (stats.numVertices > 0)
+		stats.meanResidual /= stats.numVertices;
+	return stats;
+}
+
+DragTiming Change::BenchmarkDrag(int numVertices)
+{
+	constexpr int NUM_RUNS = 5;
+	// vertices skinned by random blends of rotations, scales and translations
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> random(-1.0f, 1.0f);
+	Mesh mesh;
+	mesh.vertices.resize(numVertices);
+	std::vector<glm::vec3> positions(numVertices);
+	std::vector<glm::mat4> weightMatrices(numVertices);
+	for (int i = 0; i < numVertices; i++) {
+		mesh.vertices[i].Position = glm::vec3(random(rng), random(rng), random(rng));
+		glm::mat4 m = glm::mat4(1.0f);
+		for (int c = 0; c < 4; c++)
+			m[c] += glm::vec4(random(rng), random(rng), random(rng), 0.0f) * (c < 3 ? 0.5f : 2.0f);
+		weightMatrices[i] = m;
+		positions[i] = glm::vec3(m * glm::vec4(mesh.vertices[i].Position, 1.0f));
+	}
+	DragTiming timing;
+	timing.numVertices = numVertices;
+
+	std::vector<glm::mat3> inverses(numVertices);
+	timing.invertTime = FLT_MAX;
+	for (int run = 0; run < NUM_RUNS; run++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		InvertBlendedMatrices(weightMatrices.data(), inverses.data(), numVertices, GetBestSkinningPath());
+		timing.invertTime = std::min(timing.invertTime, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+	std::vector<ChangedVertex> changed(numVertices);
+	for (int i = 0; i < numVertices; i++)
+		changed[i] = ChangedVertex{ &positions[i], &mesh.vertices[i], &mesh, i, inverses[i] };
+	Change change(changed);
+	change.offset = glm::vec3(0.01f, -0.02f, 0.03f);
+
+	// every run moves the vertices forth and back, as a drag frame followed by an undo
+	std::vector<glm::vec3> reference(numVertices);
+	timing.uncachedTime = FLT_MAX;
+	for (int run = 0; run < NUM_RUNS; run++) {
+		for (float sign : { 1.0f, -1.0f }) {
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < numVertices; i++) {
+				positions[i] += sign * change.offset;
+				glm::mat4 inverse = glm::inverse(weightMatrices[i]);
+				mesh.vertices[i].Position += glm::vec3((inverse * glm::vec4(sign * change.offset, 0.0f)));
+				mesh.MarkDirty(i);
 			}
+			timing.uncachedTime = std::min(timing.uncachedTime, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			if (run == 0 && sign > 0.0f)
+				for (int i = 0; i < numVertices; i++)
+					reference[i] = mesh.vertices[i].Position;
+		}
+	}
+	for (unsigned int numThreads : { 1u, 0u }) {
+		float& time = numThreads == 1 ? timing.cachedTime : timing.parallelTime;
+		time = FLT_MAX;
+		for (int run = 0; run < NUM_RUNS; run++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			change.Apply(numThreads);
+			time = std::min(time, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			if (run == 0)
+				for (int i = 0; i < numVertices; i++)
+					timing.maxError = std::max(timing.maxError, glm::length(mesh.vertices[i].Position - reference[i]));
+			change.Undo(numThreads);
 		}
 	}
-}
\ No newline at end of file
+	std::cout << "Drag of " << numVertices << " vertices: " << timing.uncachedTime << " ms inverting every matrix, " << timing.cachedTime
+		<< " ms with the cached inverses, " << timing.parallelTime << " ms on " << ThreadPool::Instance().NumThreads() << " threads, "
+		<< timing.invertTime << " ms to invert them once per bake, max error " << timing.maxError << "\n";
+	return timing;
+}
+
+ReskinTiming Change::BenchmarkReskin(int numVertices)
+{
+	constexpr int NUM_BONES = 32;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> random(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> random01(0.0f, 1.0f);
+	// rigid bones: a rotation and a translation each
+	std::vector<glm::mat4> matrices(NUM_BONES);
+	for (glm::mat4& m : matrices) {
+		glm::vec3 axis = glm::normalize(glm::vec3(random(rng), random(rng), random(rng)) + glm::vec3(0.0f, 0.0f, 2.0f));
+		m = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(random(rng), random(rng), random(rng))), random(rng), axis);
+	}
+
+	// every vertex has 4 distinct bones with random convex weights, and was moved to where they skin a new bind position
+	Mesh mesh;
+	mesh.vertices.resize(numVertices);
+	std::vector<glm::vec3> positions(numVertices);
+	std::vector<float> expectedWeights(numVertices * MAX_BONE_INFLUENCE);
+	std::vector<ChangedVertex> changed(numVertices);
+	glm::vec3 offset(0.05f, 0.0f, 0.0f);
+	for (int i = 0; i < numVertices; i++) {
+		Vertex& v = mesh.vertices[i];
+		v.BoneData.NumBones = MAX_BONE_INFLUENCE;
+		float sum = 0.0f;
+		for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+			int id;
+			do {
+				id = rng() % NUM_BONES;
+			} while (std::find(v.BoneData.BoneIDs, v.BoneData.BoneIDs + k, id) != v.BoneData.BoneIDs + k);
+			v.BoneData.BoneIDs[k] = id;
+			// some bones without weight, as the propagated ones
+			expectedWeights[i * MAX_BONE_INFLUENCE + k] = k > 0 && random01(rng) < 0.3f ? 0.0f : random01(rng);
+			sum += expectedWeights[i * MAX_BONE_INFLUENCE + k];
+		}
+		glm::mat4 weightMatrix(0.0f);
+		for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+			float& w = expectedWeights[i * MAX_BONE_INFLUENCE + k];
+			w /= sum;
+			weightMatrix += w * matrices[v.BoneData.BoneIDs[k]];
+			// starting weights of the vertex, moved in the bind pose by the change
+			v.BoneData.Weights[k] = 0.25f;
+		}
+		glm::vec3 bindPosition(random(rng), random(rng), random(rng));
+		positions[i] = glm::vec3(weightMatrix * glm::vec4(bindPosition, 1.0f));
+		glm::mat3 inverse = glm::mat3(1.0f);
+		v.Position = bindPosition + inverse * offset;
+		changed[i] = ChangedVertex{ &positions[i], &v, &mesh, i, inverse };
+	}
+
+	// dynamically sized unconstrained solve of every vertex, on a copy of the same input
+	std::vector<Vertex> bindVertices = mesh.vertices;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < numVertices; i++) {
+		const Vertex& v = bindVertices[i];
+		std::vector<glm::vec3> candidates;
+		for (int k = 0; k < v.BoneData.NumBones; k++)
+			candidates.push_back(glm::vec3(matrices[v.BoneData.BoneIDs[k]] * glm::vec4(v.Position - offset, 1.0f)));
+		Eigen::MatrixXf mat = MakeEigenMatrixWithGLMVec3Cols(candidates);
+		Eigen::VectorXf weights = mat.colPivHouseholderQr().solve(ConvertGLMVec3ToEigenVec3(positions[i]));
+		bindVertices[i].BoneData.Weights[0] = weights(0);
+	}
+	float dynamicTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	Change change(changed);
+	change.offset = offset;
+	ReskinTiming timing;
+	timing.stats = change.Reskin(matrices);
+	timing.dynamicVerticesPerSecond = numVertices / (dynamicTime / 1000.0);
+	for (int i = 0; i < numVertices; i++) {
+		const VertexBoneData& bones = mesh.vertices[i].BoneData;
+		for (int k = 0; k < bones.NumBones; k++) {
+			int j = int(std::find(bindVertices[i].BoneData.BoneIDs, bindVertices[i].BoneData.BoneIDs + MAX_BONE_INFLUENCE, bones.BoneIDs[k]) - bindVertices[i].BoneData.BoneIDs);
+			timing.maxWeightError = std::max(timing.maxWeightError, std::abs(bones.Weights[k] - expectedWeights[i * MAX_BONE_INFLUENCE + j]));
+		}
+	}
+	std::cout << "Reskin of " << numVertices << " vertices: " << timing.stats.verticesPerSecond / 1e6 << " M vertices/s ("
+		<< timing.dynamicVerticesPerSecond / 1e6 << " M with a dynamic unconstrained solve), residual mean " << timing.stats.meanResidual
+		<< " max " << timing.stats.maxResidual << ", max weight error " << timing.maxWeightError << "\n";
+	return timing;
+}
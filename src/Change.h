@@ -1,19 +1,80 @@
 #pragma once
 
 #include "Vertex.h"
+#include "Mesh.h"
+#include "ReskinSolver.h"
 
 #include <vector>
 
+// vertices moved by a single task of Apply and Undo
+constexpr int CHANGE_CHUNK_SIZE = 4096;
+
+// vertex of the baked model moved by a change, with the editing data of the baked mesh it belongs to
+struct ChangedVertex {
+	// skinned position of the vertex
+	glm::vec3* position;
+	// animated vertex the baked one comes from
+	Vertex* originalVertex;
+	// animated mesh holding it, marked dirty to upload the vertex again
+	Mesh* mesh;
+	int vertexIndex;
+	// inverse of the linear part of the matrix that skinned the original vertex, cached by the bake
+	glm::mat3 inverseWeightMatrix;
+};
+
+// cost of a drag frame moving numVertices vertices
+struct DragTiming {
+	int numVertices = 0;
+	// inverting the skinning matrix of every vertex on every move (ms)
+	float uncachedTime = 0.0f;
+	// with the inverses cached by the bake, on one thread and on all of them (ms)
+	float cachedTime = 0.0f;
+	float parallelTime = 0.0f;
+	// batched inversion of the matrices, once per bake (ms)
+	float invertTime = 0.0f;
+	// largest difference between the moved vertices and the ones moved with glm::inverse
+	float maxError = 0.0f;
+};
+
+// weights of the vertices of a change solved again
+struct ReskinStats {
+	int numVertices = 0;
+	// time spent solving (ms) and its throughput
+	float time = 0.0f;
+	double verticesPerSecond = 0.0;
+	// distance between the vertices skinned with the new weights and their edited positions
+	float meanResidual = 0.0f;
+	float maxResidual = 0.0f;
+};
+
+// reskinning of numVertices synthetic vertices by the solver and by a dynamically sized unconstrained solve per vertex
+struct ReskinTiming {
+	ReskinStats stats;
+	double dynamicVerticesPerSecond = 0.0;
+	// largest difference between the solved weights and the ones that skinned the targets
+	float maxWeightError = 0.0f;
+};
 
 class Change {
 public:
 	glm::vec3 offset;
 
-	Change(std::vector<Vertex*>& changedVertices);
-	void Apply();
-	void Undo();
+	Change(const std::vector<ChangedVertex>& changedVertices = std::vector<ChangedVertex>());
+	// both move the vertices in chunks on numThreads threads (0 = all of them), then mark them dirty in their animated meshes
+	void Apply(unsigned int numThreads = 0);
+	void Undo(unsigned int numThreads = 0);
 	void Modify(glm::vec3 newoffset);
-	void Reskin(std::vector<glm::mat4>& matrices);
+	// instead of moving the vertices in the bind pose, restores their bind pose positions and solves the weights of their
+	// bones so that the bone matrices skin them to the edited positions. The change must be applied, the weights are
+	// written heaviest first and the pose must be baked again. Runs in chunks on numThreads threads (0 = all of them).
+	ReskinStats Reskin(const std::vector<glm::mat4>& matrices, const ReskinOptions& options = ReskinOptions(), unsigned int numThreads = 0);
+	// drags numVertices synthetic vertices with and without the cached inverses, the best of a few runs each
+	static DragTiming BenchmarkDrag(int numVertices = 100000);
+	// reskins numVertices synthetic vertices whose targets can be reached exactly with the constraints
+	static ReskinTiming BenchmarkReskin(int numVertices = 100000);
 private:
-	std::vector<Vertex*> changedVertices;
-};
\ No newline at end of file
+	std::vector<ChangedVertex> changedVertices;
+
+	// moves the skinned vertices by delta and the original ones by delta brought back to the bind pose
+	void Move(glm::vec3 delta, unsigned int numThreads);
+};
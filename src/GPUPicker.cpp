@@ -0,0 +1,131 @@
+#include "GPUPicker.h"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+void GPUPicker::Resize(int newWidth, int newHeight)
+{
+	if (fbo == 0) {
+		glGenFramebuffers(1, &fbo);
+		glGenTextures(1, &idTexture);
+		glGenRenderbuffers(1, &depthBuffer);
+		for (Readback& readback : readbacks) {
+			glGenBuffers(1, &readback.pbo);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, 4 * sizeof(GLuint), NULL, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	width = newWidth;
+	height = newHeight;
+	// mesh id + 1, triangle id + 1 (0 is the background) and the bits of the depth of each pixel
+	glBindTexture(GL_TEXTURE_2D, idTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, width, height, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, idTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::GPU_PICKER:: Framebuffer is not complete!\n";
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GPUPicker::Render(std::vector<Mesh>& meshes, const Shader& shader, int screenWidth, int screenHeight, glm::vec2 mousePos, const glm::mat4& viewProjection)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	frame++;
+	if (screenWidth <= 0 || screenHeight <= 0)
+		return;
+	if (fbo == 0 || screenWidth != width || screenHeight != height)
+		Resize(screenWidth, screenHeight);
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+	const GLuint background[4] = { 0, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, background);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	shader.use();
+	for (int i = 0; i < meshes.size(); i++) {
+		if (!meshes[i].enabled) continue;
+		shader.setInt("meshID", i + 1);
+		meshes[i].Draw();
+	}
+
+	// copy the pixel under the mouse in a free pixel buffer, it's mapped once its fence is signaled
+	int x = std::clamp(int(mousePos.x), 0, width - 1);
+	int y = std::clamp(height - 1 - int(mousePos.y), 0, height - 1);
+	Readback& readback = readbacks[next];
+	if (readback.fence == nullptr) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glReadPixels(x, y, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT, (void*)0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		readback.frame = frame;
+		readback.toWorld = glm::inverse(viewProjection);
+		// center of the pixel
+		readback.ndc = glm::vec2((x + 0.5f) / width, (y + 0.5f) / height) * 2.0f - 1.0f;
+		next = (next + 1) % GPU_PICKING_READBACKS;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	renderTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+std::optional<GPUPickResult> GPUPicker::Poll()
+{
+	std::optional<GPUPickResult> result;
+	// the readbacks complete in the order they were issued, starting from the oldest one
+	for (int k = 0; k < GPU_PICKING_READBACKS; k++) {
+		Readback& readback = readbacks[(next + k) % GPU_PICKING_READBACKS];
+		if (readback.fence == nullptr)
+			continue;
+		GLenum status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+
+		GLuint pixel[4] = { 0, 0, 0, 0 };
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+		void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(pixel), GL_MAP_READ_BIT);
+		if (mapped) {
+			std::copy_n(static_cast<const GLuint*>(mapped), 4, pixel);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		GPUPickResult pick;
+		pick.latency = lastLatency = frame - readback.frame;
+		if (pixel[0] > 0) {
+			pick.meshIndex = int(pixel[0]) - 1;
+			pick.face = int(pixel[1]) - 1;
+			float depth;
+			std::memcpy(&depth, &pixel[2], sizeof(float));
+			glm::vec4 point = readback.toWorld * glm::vec4(readback.ndc, depth * 2.0f - 1.0f, 1.0f);
+			pick.hitPoint = glm::vec3(point) / point.w;
+			// along the ray from the near plane, as the cpu picking does
+			glm::vec4 rayStart = readback.toWorld * glm::vec4(readback.ndc, -1.0f, 1.0f);
+			pick.distance = glm::length(pick.hitPoint - glm::vec3(rayStart) / rayStart.w);
+		}
+		result = pick;
+	}
+	return result;
+}
+
+int GPUPicker::GetPendingReadbacks() const
+{
+	return int(std::count_if(readbacks.begin(), readbacks.end(), [](const Readback& readback) { return readback.fence != nullptr; }));
+}
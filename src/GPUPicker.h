@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Mesh.h"
+#include "Shader.h"
+
+#include <array>
+#include <vector>
+#include <optional>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// pixels being read back at the same time, a new request is skipped while all of them are in flight
+constexpr int GPU_PICKING_READBACKS = 3;
+
+struct GPUPickResult {
+	// -1 if the pixel shows the background
+	int meshIndex = -1;
+	int face = -1;
+	glm::vec3 hitPoint = glm::vec3(0.0f);
+	float distance = -1.0f;
+	// frames between the request and its result
+	int latency = 0;
+};
+
+// picks by rendering the mesh and triangle ids of the model in an integer framebuffer. Only the pixel under
+// the mouse is read back, through a pixel buffer that is mapped frames later, once the gpu is done with it.
+class GPUPicker {
+public:
+	// time spent issuing the id pass and the readback (ms, cpu side)
+	float renderTime = 0.0f;
+	// latency of the last result (frames)
+	int lastLatency = 0;
+
+	GPUPicker() = default;
+	GPUPicker(const GPUPicker& other) = delete;
+	GPUPicker& operator=(const GPUPicker& other) = delete;
+
+	// renders the ids of the enabled meshes with the shader, already set up with the matrices and the bones of
+	// this frame, and requests the pixel under the mouse (window coordinates, origin at the top-left)
+	void Render(std::vector<Mesh>& meshes, const Shader& shader, int screenWidth, int screenHeight, glm::vec2 mousePos, const glm::mat4& viewProjection);
+	// most recent result among the readbacks completed since the last call, never waits for the gpu
+	std::optional<GPUPickResult> Poll();
+	int GetPendingReadbacks() const;
+
+private:
+	struct Readback {
+		GLuint pbo = 0;
+		// signaled once the pixel has been copied in the buffer
+		GLsync fence = nullptr;
+		int frame = 0;
+		// to rebuild the hit point from the depth of the pixel
+		glm::mat4 toWorld;
+		glm::vec2 ndc;
+	};
+
+	GLuint fbo = 0, idTexture = 0, depthBuffer = 0;
+	int width = 0, height = 0;
+	std::array<Readback, GPU_PICKING_READBACKS> readbacks;
+	// next readback to issue, the oldest one in flight if any
+	int next = 0;
+	int frame = 0;
+
+	// creates the framebuffer the first time, then resizes its attachments
+	void Resize(int newWidth, int newHeight);
+};
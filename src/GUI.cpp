@@ -15,6 +15,7 @@ void RenderGUI(StatusManager& status)
 	RenderAnimatorInfo(status);
 	RenderLightingInfo(status);
 	RenderVisualModeInfo(status);
+	RenderLoadingInfo(status);
 	// Rendering
 	ImGui::Render();
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -104,7 +105,6 @@ void OpenMeshDialog(StatusManager& status)
 		if (ifd::FileDialog::Instance().HasResult()) {
 			std::string res = ifd::FileDialog::Instance().GetResult().u8string();
 			status.LoadModel(res);
-			status.AddAnimation(res.c_str());
 		}
 		ifd::FileDialog::Instance().Close();
 	}
@@ -182,6 +182,135 @@ void RenderModelInfo(StatusManager& status)
 	ImGui::Begin("Model", &showModel);
 
 	ImGui::Checkbox("Show Wireframe", &status.wireframeEnabled);
+	ImGui::Checkbox("Use model cache", &status.useModelCache);
+	ImGui::Checkbox("Verify weight propagation (slow)", &status.verifyPropagation);
+	ImGui::SliderInt("Propagation threads (0 = all)", &status.propagationThreads, 0, ThreadPool::Instance().NumThreads());
+	if (status.animatedModel)
+	{
+		Model& model = status.animatedModel.value();
+		std::string loadInfo = std::string("Loaded from ") + (model.loadedFromCache ? "cache" : "assimp") + " in " + std::to_string(model.loadTime) + " ms";
+		ImGui::Text(loadInfo.c_str());
+		if (model.loadedFromCache)
+		{
+			std::string comparison = "Assimp path: " + std::to_string(model.importTime) + " ms";
+			ImGui::Text(comparison.c_str());
+		}
+		// the buffers used to hold every field of Vertex and 32 bit indices
+		size_t fullLayoutBytes = 0;
+		for (Mesh& m : model.meshes)
+			fullLayoutBytes += m.vertices.size() * (sizeof(Vertex) + sizeof(glm::mat4) + sizeof(Vertex*)) + m.faces.size() * sizeof(Face);
+		ImGui::Text("VRAM: %.1f KB (%.1f KB with the unpacked vertices)", model.GetGPUBytes() / 1024.0f, fullLayoutBytes / 1024.0f);
+		ImGui::Text("Last reload: %.2f ms", model.reloadTime);
+		ImGui::Text("Last edit upload: %.1f KB in %.3f ms", model.uploadBytes / 1024.0f, model.uploadTime);
+		size_t topologyBytes = 0;
+		float topologyTime = 0.0f;
+		for (Mesh& m : model.meshes)
+		{
+			topologyBytes += m.GetTopology().GetMemoryBytes();
+			topologyTime += m.GetTopology().buildTime;
+		}
+		ImGui::Text("Adjacency: %.1f KB, built in %.2f ms", topologyBytes / 1024.0f, topologyTime);
+		if (ImGui::Button("Compare with std::set graph")) {
+			setGraphBytes = 0;
+			setGraphTime = 0.0f;
+			for (Mesh& m : model.meshes)
+			{
+				size_t bytes;
+				float time;
+				MeshTopology::MeasureSetGraph(m.faces, m.vertices.size(), bytes, time);
+				setGraphBytes += bytes;
+				setGraphTime += time;
+			}
+		}
+		if (setGraphBytes > 0)
+			ImGui::Text("std::set graph: %.1f KB, built in %.2f ms", setGraphBytes / 1024.0f, setGraphTime);
+		if (ImGui::Button("Benchmark propagation")) {
+			propagationBenchmark = model.BenchmarkPropagation();
+		}
+		for (PropagationTiming& timing : propagationBenchmark)
+		{
+			float speedup = propagationBenchmark[0].time / timing.time;
+			ImGui::Text("%u threads: %.1f ms (x%.2f), %d mismatches", timing.numThreads, timing.time, speedup, timing.mismatches);
+		}
+		ImGui::Text("Skinning: %s", GetSkinningPathName(GetBestSkinningPath()));
+		if (status.bakedModel)
+			ImGui::Text("Baked pose: %.1f KB, baked in %.2f ms", status.bakedModel->GetMemoryBytes() / 1024.0f, status.bakedModel->bakeTime);
+		if (ImGui::Button("Benchmark baking")) {
+			bakeBenchmark = model.BenchmarkBake(status.animator.GetFinalBoneMatrices());
+		}
+		for (BakeTiming& timing : bakeBenchmark)
+		{
+			float speedup = bakeBenchmark[0].time / timing.time;
+			ImGui::Text("%s: %.2f ms (x%.2f), max error %g", GetSkinningPathName(timing.path), timing.time, speedup, timing.maxError);
+		}
+		if (ImGui::Button("Benchmark baking threads (1M vertices)")) {
+			bakeScalingBenchmark = Model::BenchmarkBakeScaling(1000000);
+		}
+		for (BakeScalingTiming& timing : bakeScalingBenchmark)
+		{
+			float speedup = bakeScalingBenchmark[0].time / timing.time;
+			ImGui::Text("%u threads: %.1f ms (x%.2f)", timing.numThreads, timing.time, speedup);
+		}
+		if (ImGui::Button("Benchmark drag (100k vertices)")) {
+			dragBenchmark = Change::BenchmarkDrag(100000);
+		}
+		if (dragBenchmark.numVertices > 0)
+		{
+			ImGui::Text("Inverting every move: %.2f ms, cached: %.2f ms, parallel: %.2f ms", dragBenchmark.uncachedTime,
+				dragBenchmark.cachedTime, dragBenchmark.parallelTime);
+			ImGui::Text("Inverses once per bake: %.2f ms, max error %g", dragBenchmark.invertTime, dragBenchmark.maxError);
+		}
+		if (ImGui::Button("Benchmark reskin (100k vertices)")) {
+			reskinBenchmark = Change::BenchmarkReskin(100000);
+		}
+		if (reskinBenchmark.stats.numVertices > 0)
+		{
+			ImGui::Text("Reskin: %.2f M vertices/s (dynamic solve %.2f M), residual mean %g max %g", reskinBenchmark.stats.verticesPerSecond / 1e6,
+				reskinBenchmark.dynamicVerticesPerSecond / 1e6, reskinBenchmark.stats.meanResidual, reskinBenchmark.stats.maxResidual);
+			ImGui::Text("Max weight error %g", reskinBenchmark.maxWeightError);
+		}
+		if (ImGui::Button("Benchmark triangle kernel")) {
+			triangleBenchmark = TriangleBenchmark::Run();
+		}
+		for (TriangleKernelTiming& timing : triangleBenchmark)
+		{
+			float speedup = timing.trianglesPerSecond / triangleBenchmark[0].trianglesPerSecond;
+			ImGui::Text("%s: %.1f M triangles/s (x%.2f), %d mismatches, max error %g", GetTrianglePathName(timing.path),
+				timing.trianglesPerSecond / 1e6, speedup, timing.mismatches, timing.maxDistanceError);
+		}
+		// the latency is measured up to the swap of the frame that handled the input, the display adds its scan-out
+		ImGui::Text("Input: %llu events received, %llu processed", status.inputQueue.eventsReceived, status.inputQueue.eventsProcessed);
+		ImGui::Text("Input to swap: %.2f ms (avg %.2f ms, max %.2f ms)", status.inputQueue.lastLatency, status.inputQueue.averageLatency,
+			status.inputQueue.maxLatency);
+		ImGui::Checkbox("Pick while playing", &status.pickWhilePlaying);
+		if (status.bakedModel)
+		{
+			ImGui::Text("Picking BVH: %.1f KB, built in %.2f ms", status.bakedModel->GetBVHMemoryBytes() / 1024.0f, status.bakedModel->bvhBuildTime);
+			ImGui::Checkbox("Pick with the BVH", &status.usePickingBVH);
+			ImGui::Checkbox("Pick on the GPU", &status.useGPUPicking);
+			if (status.useGPUPicking)
+				ImGui::Text("GPU pick: %d frames of latency, %d readbacks in flight, %.3f ms", status.gpuPicker.lastLatency,
+					status.gpuPicker.GetPendingReadbacks(), status.gpuPicker.renderTime);
+			ImGui::Text("Last pick: %d triangles tested, %.3f ms", status.lastPickTrianglesTested, status.lastPickTime);
+			if (!status.pause)
+				ImGui::Text("Per frame: baked in %.2f ms, BVH refitted in %.3f ms", status.bakedModel->bakeTime, status.bakedModel->bvhRefitTime);
+			if (ImGui::Button("Benchmark BVH refit")) {
+				bvhUpdateBenchmark = status.bakedModel->BenchmarkBVHUpdate();
+			}
+			if (bvhUpdateBenchmark.numTriangles > 0)
+				ImGui::Text("%d triangles: refit %.3f ms, rebuild %.2f ms (x%.1f)", bvhUpdateBenchmark.numTriangles, bvhUpdateBenchmark.refitTime,
+					bvhUpdateBenchmark.rebuildTime, bvhUpdateBenchmark.rebuildTime / bvhUpdateBenchmark.refitTime);
+			if (ImGui::Button("Benchmark picking")) {
+				pickingBenchmark = status.BenchmarkPicking(1000);
+			}
+			if (pickingBenchmark.numRays > 0)
+			{
+				ImGui::Text("BVH: %.4f ms, %.1f triangles per pick", pickingBenchmark.bvhTime, pickingBenchmark.bvhTrianglesTested);
+				ImGui::Text("Brute force: %.4f ms, %.1f triangles per pick", pickingBenchmark.bruteForceTime, pickingBenchmark.bruteForceTrianglesTested);
+				ImGui::Text("%d mismatches over %d rays", pickingBenchmark.mismatches, pickingBenchmark.numRays);
+			}
+		}
+	}
 
 	RenderMeshesInfo(status);
 	ImGui::End();
@@ -244,6 +373,27 @@ void RenderAnimatorInfo(StatusManager& status)
 	float animDuration = anim.GetDuration();
 	std::string durationText = "Duration: " + std::to_string(animDuration);
 	ImGui::Text(durationText.c_str());
+	std::string allocationsText = "Allocations per update: " + std::to_string(status.animator.GetLastUpdateAllocations());
+	ImGui::Text(allocationsText.c_str());
+	ImGui::Text("Keyframes: %.1f KB (%.1f KB uncompressed)", anim.keyframeBytes / 1024.0f, anim.uncompressedBytes / 1024.0f);
+	if (ImGui::TreeNode("Compression of the next imports"))
+	{
+		KeyframeCompression& compression = status.animationCompression;
+		ImGui::Checkbox("Compress keyframes", &compression.enabled);
+		ImGui::DragFloat("Position tolerance", &compression.positionTolerance, 0.0001f, 0.0f, 1.0f, "%.4f");
+		ImGui::DragFloat("Rotation tolerance (deg)", &compression.rotationTolerance, 0.01f, 0.0f, 10.0f, "%.3f");
+		ImGui::DragFloat("Scale tolerance", &compression.scaleTolerance, 0.0001f, 0.0f, 1.0f, "%.4f");
+		ImGui::Checkbox("Quantize rotations (48 bit)", &compression.quantizeRotations);
+		ImGui::TreePop();
+	}
+	bool useResampledTracks = status.animator.useResampledTracks;
+	if (ImGui::Checkbox("Resampled tracks", &useResampledTracks))
+		status.animator.SetUseResampledTracks(useResampledTracks);
+	if (const ResampledClip* resampled = anim.GetResampled())
+	{
+		ImGui::Text("%d tracks, %d frames, %.1f KB", resampled->GetNumTracks(), resampled->GetNumFrames(), resampled->GetMemoryBytes() / 1024.0f);
+		ImGui::Text("Max error: position %.4f, rotation %.3f deg, scale %.4f", resampled->maxPositionError, resampled->maxRotationError, resampled->maxScaleError);
+	}
 
 	ImGui::Separator();
 	float currentTime = status.animator.m_CurrentTime;
@@ -253,9 +403,34 @@ void RenderAnimatorInfo(StatusManager& status)
 	ImGui::DragFloatRange2("Current Range", &start, &end, 1.0f, 0.0f, animDuration);
 	currentTime = std::clamp(currentTime, start, end);
 	if (currentTime != status.animator.m_CurrentTime)
+		status.animator.SetTime(currentTime);
+	// step of one tick
+	if (ImGui::Button("<")) {
+		status.animator.SetTime(std::max(start, currentTime - 1.0f));
+	}
+	ImGui::SameLine();
+	if (ImGui::Button(">")) {
+		status.animator.SetTime(std::min(end, currentTime + 1.0f));
+	}
+
+	bool usePoseCache = status.animator.usePoseCache;
+	if (ImGui::Checkbox("Cache poses for scrubbing", &usePoseCache))
+		status.animator.SetUsePoseCache(usePoseCache);
+	if (status.animator.usePoseCache)
 	{
-		status.animator.m_CurrentTime = currentTime;
-		status.animator.UpdateAnimation(0.0f);
+		ImGui::SameLine();
+		ImGui::Checkbox("Blend", &status.animator.blendPoseCache);
+		int budgetMB = status.animator.poseCacheBudget / (1024 * 1024);
+		if (ImGui::SliderInt("Budget (MB)", &budgetMB, 1, 512))
+			status.animator.poseCacheBudget = size_t(budgetMB) * 1024 * 1024;
+		if (const PoseCache* cache = anim.GetPoseCache())
+		{
+			ImGui::ProgressBar(cache->GetProgress(), ImVec2(0.0f, 0.0f));
+			ImGui::Text("%d frames, %.1f MB, hit rate %.1f%%", cache->GetNumFrames(), cache->GetMemoryBytes() / (1024.0f * 1024.0f), status.animator.GetPoseCacheHitRate() * 100.0f);
+		}
+		if (ImGui::Button("Rebuild cache")) {
+			anim.BuildPoseCache(status.animator.poseCacheBudget);
+		}
 	}
 
 	if (ImGui::Button("Previous Animation")) {
@@ -266,6 +441,21 @@ void RenderAnimatorInfo(StatusManager& status)
 		status.animator.PlayNextAnimation();
 	}
 
+	if (ImGui::Button("Benchmark keyframe search"))
+		keyframeBenchmark = KeyframeBenchmark::Run();
+	if (keyframeBenchmark.numBones > 0)
+	{
+		ImGui::Text("%d bones, %d keys (ns per sample)", keyframeBenchmark.numBones, keyframeBenchmark.numKeys);
+		ImGui::Text("Linear scan: %.1f  Cursor: %.1f  Binary search: %.1f", keyframeBenchmark.linearScan, keyframeBenchmark.cursor, keyframeBenchmark.binarySearch);
+	}
+	if (ImGui::Button("Benchmark resampled tracks"))
+		samplingBenchmark = KeyframeBenchmark::RunSampling();
+	if (samplingBenchmark.numBones > 0)
+	{
+		ImGui::Text("Bones per second: keyframes %.3g, resampled %.3g", samplingBenchmark.keyframes, samplingBenchmark.resampled);
+		ImGui::Text("Max error: position %.4f, rotation %.3f deg", samplingBenchmark.maxPositionError, samplingBenchmark.maxRotationError);
+	}
+
 	int size = status.animator.animations.size();
 	std::string otherAnim = "Other animations (" + std::to_string(size - 1) + ")";
 	if (!ImGui::CollapsingHeader(otherAnim.c_str()))
@@ -284,6 +474,23 @@ void RenderAnimatorInfo(StatusManager& status)
 	ImGui::End();
 }
 
+void RenderLoadingInfo(StatusManager& status)
+{
+	if (!status.loader.IsLoading())
+		return;
+	ImGui::Begin("Loading");
+	std::string path = "Loading " + status.loader.GetPath();
+	ImGui::Text(path.c_str());
+	const LoadProgress* progress = status.loader.GetProgress();
+	ImGui::Text(LoadProgress::GetStageName(progress->stage));
+	ImGui::ProgressBar(progress->GetFraction());
+	std::string frameTime = "Frame time: " + std::to_string(1000.0f / ImGui::GetIO().Framerate) + " ms";
+	ImGui::Text(frameTime.c_str());
+	if (ImGui::Button("Cancel"))
+		status.loader.Cancel();
+	ImGui::End();
+}
+
 void RenderVisualModeInfo(StatusManager& status)
 {
 	if (!showVisualMode) return;
@@ -319,6 +526,11 @@ void ShowAnimationNInfo(Animator& animator, int n) {
 
 	std::string ticks = "Tick per second: " + std::to_string(anim.GetTicksPerSecond());
 	ImGui::Text(ticks.c_str());
+
+	std::string importInfo = "Imported in " + std::to_string(anim.importTime) + " ms, parsed " + std::to_string(anim.parsedBytes / 1024)
+		+ "/" + std::to_string(anim.fileBytes / 1024) + " KB, scene " + std::to_string(anim.sceneBytes / 1024) + " KB";
+	ImGui::Text(importInfo.c_str());
+	ImGui::Text("Keyframes: %.1f KB (%.1f KB uncompressed)", anim.keyframeBytes / 1024.0f, anim.uncompressedBytes / 1024.0f);
 }
 
 //void RenderRenderInfo(StatusManager& status)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "StatusManager.h"
+#include "KeyframeBenchmark.h"
+#include "TriangleBenchmark.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
@@ -25,6 +27,19 @@ static bool showLighting = true;
 static bool showVisualMode = true;
 
 static std::vector<int> panelTex;
+static KeyframeBenchmarkResult keyframeBenchmark;
+static SamplingBenchmarkResult samplingBenchmark;
+static std::vector<PropagationTiming> propagationBenchmark;
+static std::vector<BakeTiming> bakeBenchmark;
+static std::vector<BakeScalingTiming> bakeScalingBenchmark;
+static PickingBenchmarkResult pickingBenchmark;
+static BVHUpdateTiming bvhUpdateBenchmark;
+static std::vector<TriangleKernelTiming> triangleBenchmark;
+static DragTiming dragBenchmark;
+static ReskinTiming reskinBenchmark;
+// memory (bytes) and build time (ms) of the std::set graph of the loaded model
+static size_t setGraphBytes = 0;
+static float setGraphTime = 0.0f;
 
 void SetupImGui(GLFWwindow* window);
 void CloseImGui();
@@ -45,6 +60,7 @@ void RenderCameraInfo(StatusManager& status);
 void RenderMeshTextureInfo(Mesh& mesh, int meshIndex, int textureIndex, TextureManager& texMan);
 void ShowTextureInPanel(int m, int textureIndex, ImTextureID id, int width, int height);
 void RenderAnimatorInfo(StatusManager& status);
+void RenderLoadingInfo(StatusManager& status);
 void RenderVisualModeInfo(StatusManager& status);
 void ShowAnimationNInfo(Animator& animator, int n);
 //void RenderRenderInfo(StatusManager& status);
@@ -0,0 +1,43 @@
+#include "InputQueue.h"
+
+#include <algorithm>
+
+namespace {
+	// frames averaged by the latency
+	constexpr int LATENCY_WINDOW = 60;
+}
+
+void InputQueue::Push(const InputEvent& event)
+{
+	eventsReceived++;
+	pending.push_back(event);
+}
+
+std::vector<InputEvent> InputQueue::TakeCoalesced()
+{
+	std::vector<InputEvent> events;
+	events.reserve(pending.size());
+	for (int i = 0; i < pending.size(); i++) {
+		// only the last position of the moves between two other events matters
+		if (pending[i].type == Input_MouseMove && i + 1 < pending.size() && pending[i + 1].type == Input_MouseMove)
+			continue;
+		events.push_back(pending[i]);
+	}
+	if (!pending.empty() && oldestTaken < 0.0)
+		oldestTaken = pending.front().time;
+	eventsProcessed += events.size();
+	pending.clear();
+	return events;
+}
+
+void InputQueue::FramePresented(double time)
+{
+	if (oldestTaken < 0.0)
+		return;
+	lastLatency = float((time - oldestTaken) * 1000.0);
+	oldestTaken = -1.0;
+	// running average over the last frames with input
+	latencySamples = std::min(latencySamples + 1, LATENCY_WINDOW);
+	averageLatency += (lastLatency - averageLatency) / latencySamples;
+	maxLatency = std::max(maxLatency, lastLatency);
+}
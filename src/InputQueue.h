@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+enum InputEventType
+{
+	Input_MouseMove,
+	Input_MouseButton,
+	Input_Key,
+	Input_Scroll
+};
+
+struct InputEvent {
+	InputEventType type;
+	// cursor position or scroll offsets
+	double x = 0.0;
+	double y = 0.0;
+	// mouse button or key, with the values given by glfw
+	int code = 0;
+	int scancode = 0;
+	int action = 0;
+	int mods = 0;
+	// when the callback received it (s)
+	double time = 0.0;
+};
+
+// input received by the glfw callbacks, handled once per frame so that the expensive reactions to the
+// mouse movements (picking, tweaking) run at most once per rendered frame
+class InputQueue {
+public:
+	// totals since the start, the processed events are the received ones left after merging the moves
+	unsigned long long eventsReceived = 0;
+	unsigned long long eventsProcessed = 0;
+	// time from the oldest event handled by a frame to the swap of that frame (ms)
+	float lastLatency = 0.0f;
+	float averageLatency = 0.0f;
+	float maxLatency = 0.0f;
+
+	void Push(const InputEvent& event);
+	// events received since the last call in order, every run of consecutive moves merged into its last move
+	std::vector<InputEvent> TakeCoalesced();
+	// to call once the frame handling the taken events has been swapped, at time (s)
+	void FramePresented(double time);
+
+private:
+	std::vector<InputEvent> pending;
+	// oldest event handled by the current frame, negative if none
+	double oldestTaken = -1.0;
+	int latencySamples = 0;
+};
@@ -0,0 +1,139 @@
+#include "KeyframeBenchmark.h"
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+
+namespace {
+	// channel with one key per tick on every track, moving smoothly like a motion capture
+	aiNodeAnim* CreateChannel(int numKeys, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> phase(0.0f, 6.28f);
+		float p = phase(rng), r = phase(rng);
+		aiNodeAnim* channel = new aiNodeAnim();
+		channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = numKeys;
+		channel->mPositionKeys = new aiVectorKey[numKeys];
+		channel->mRotationKeys = new aiQuatKey[numKeys];
+		channel->mScalingKeys = new aiVectorKey[numKeys];
+		for (int i = 0; i < numKeys; i++) {
+			channel->mPositionKeys[i] = aiVectorKey(i, aiVector3D(std::sin(0.05f * i + p), std::cos(0.03f * i + p), 0.1f * std::sin(0.1f * i)));
+			channel->mRotationKeys[i] = aiQuatKey(i, aiQuaternion(aiVector3D(0, 1, 0), std::sin(0.02f * i + r)));
+			channel->mScalingKeys[i] = aiVectorKey(i, aiVector3D(1.0f));
+		}
+		return channel;
+	}
+
+	std::vector<Bone> CreateBones(int numBones, int numKeys, std::mt19937& rng)
+	{
+		std::vector<Bone> bones;
+		bones.reserve(numBones);
+		for (int i = 0; i < numBones; i++) {
+			aiNodeAnim* channel = CreateChannel(numKeys, rng);
+			bones.emplace_back("Bone" + std::to_string(i), i, channel);
+			delete channel;
+		}
+		return bones;
+	}
+
+	template<typename F>
+	double MeasureNs(int numSamples, F&& sample)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		sample();
+		return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / numSamples;
+	}
+}
+
+KeyframeBenchmarkResult KeyframeBenchmark::Run(int numBones, int numKeys, int numFrames)
+{
+	KeyframeBenchmarkResult result;
+	result.numBones = numBones;
+	result.numKeys = numKeys;
+
+	std::mt19937 rng(42);
+	std::vector<Bone> bones = CreateBones(numBones, numKeys, rng);
+	std::vector<float> timeStamps(numKeys);
+	for (int i = 0; i < numKeys; i++)
+		timeStamps[i] = i;
+
+	float duration = numKeys - 1;
+	std::vector<float> playbackTimes(numFrames);
+	std::vector<float> scrubTimes(numFrames);
+	std::uniform_real_distribution<float> randomTime(0.0f, duration);
+	for (int i = 0; i < numFrames; i++) {
+		// two frames per key, as a 30 fps clip played at 60 fps
+		playbackTimes[i] = i * 0.5f;
+		scrubTimes[i] = randomTime(rng);
+	}
+
+	int numSamples = numBones * numFrames;
+	// keeps the searches from being optimized away
+	volatile int checksum = 0;
+	// each bone plays a different part of the clip, so the whole track is covered
+	auto boneTime = [&](float time, int b) { return std::fmod(time + duration * b / numBones, duration); };
+	result.linearScan = MeasureNs(numSamples, [&]() {
+		for (float time : playbackTimes)
+			for (int b = 0; b < numBones; b++) {
+				float t = boneTime(time, b);
+				for (int index = 1; index < numKeys; ++index)
+					if (t < timeStamps[index]) {
+						checksum += index - 1;
+						break;
+					}
+			}
+	});
+	std::vector<KeyframeCursor> cursors(numBones);
+	result.cursor = MeasureNs(numSamples, [&]() {
+		for (float time : playbackTimes)
+			for (int b = 0; b < numBones; b++)
+				checksum += bones[b].GetPositionIndex(boneTime(time, b), cursors[b].position);
+	});
+	result.binarySearch = MeasureNs(numSamples, [&]() {
+		for (float time : scrubTimes)
+			for (int b = 0; b < numBones; b++)
+				checksum += bones[b].GetPositionIndex(time);
+	});
+
+	std::cout << "Keyframe search of " << numBones << " bones with " << numKeys << " keys (ns per sample): linear scan "
+		<< result.linearScan << ", cursor " << result.cursor << ", binary search " << result.binarySearch << "\n";
+	return result;
+}
+
+SamplingBenchmarkResult KeyframeBenchmark::RunSampling(int numBones, int numKeys, int numFrames)
+{
+	SamplingBenchmarkResult result;
+	result.numBones = numBones;
+	result.numKeys = numKeys;
+
+	std::mt19937 rng(42);
+	std::vector<Bone> bones = CreateBones(numBones, numKeys, rng);
+	std::vector<int> nodes(numBones);
+	for (int i = 0; i < numBones; i++)
+		nodes[i] = i;
+	// one key per tick at 24 ticks per second, resampled at the default rate
+	float ticksPerSecond = 24.0f;
+	ResampledClip clip(bones, nodes, numKeys - 1, ticksPerSecond);
+	result.maxPositionError = clip.maxPositionError;
+	result.maxRotationError = clip.maxRotationError;
+
+	std::vector<glm::mat4> localTransforms(numBones);
+	std::vector<KeyframeCursor> cursors(numBones);
+	float frameTime = ticksPerSecond / RESAMPLE_RATE;
+	int numSamples = numBones * numFrames;
+	result.keyframes = 1e9 / MeasureNs(numSamples, [&]() {
+		for (int frame = 0; frame < numFrames; frame++)
+			for (int b = 0; b < numBones; b++)
+				localTransforms[b] = bones[b].GetLocalTransform(frame * frameTime, cursors[b]);
+	});
+	result.resampled = 1e9 / MeasureNs(numSamples, [&]() {
+		for (int frame = 0; frame < numFrames; frame++)
+			clip.Sample(frame * frameTime, localTransforms);
+	});
+
+	std::cout << "Sampling " << numBones << " bones with " << numKeys << " keys (bones per second): keyframes "
+		<< result.keyframes << ", resampled " << result.resampled << ", max error: position " << result.maxPositionError
+		<< ", rotation " << result.maxRotationError << " deg\n";
+	return result;
+}
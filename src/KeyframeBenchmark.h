@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Bone.h"
+#include "ResampledClip.h"
+
+// time spent finding the keys of a sample (ns), with the three ways of searching a track
+struct KeyframeBenchmarkResult {
+	int numBones = 0;
+	int numKeys = 0;
+	// scan from the first key, as the bones used to do
+	double linearScan = 0.0;
+	// forward playback with the per-track cursors
+	double cursor = 0.0;
+	// random times, as when scrubbing with the slider
+	double binarySearch = 0.0;
+};
+
+// bones sampled per second, from the original keys and from the resampled tracks
+struct SamplingBenchmarkResult {
+	int numBones = 0;
+	int numKeys = 0;
+	double keyframes = 0.0;
+	double resampled = 0.0;
+	float maxPositionError = 0.0f;
+	float maxRotationError = 0.0f;
+};
+
+// samples synthetic bones with long tracks and compares the keyframe searches
+namespace KeyframeBenchmark {
+	KeyframeBenchmarkResult Run(int numBones = 100, int numKeys = 10000, int numFrames = 1000);
+	SamplingBenchmarkResult RunSampling(int numBones = 100, int numKeys = 10000, int numFrames = 1000);
+}
@@ -0,0 +1,59 @@
+#include "KeyframeCompression.h"
+
+#include <cmath>
+
+namespace {
+	constexpr float QUANTIZATION_SCALE = 32767.0f;
+	// the three smallest components of a unit quaternion are within +-1/sqrt(2)
+	constexpr float SMALLEST_RANGE = 0.70710678f;
+}
+
+PackedQuat PackQuat(glm::quat q)
+{
+	q = glm::normalize(q);
+	float components[4] = { q.x, q.y, q.z, q.w };
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+		if (std::abs(components[i]) > std::abs(components[largest]))
+			largest = i;
+	// q and -q are the same rotation, so the largest component is stored as positive
+	float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+	PackedQuat packed;
+	for (int i = 0, n = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		float value = std::clamp(sign * components[i] / SMALLEST_RANGE, -1.0f, 1.0f);
+		packed.data[n++] = uint16_t(std::lround((value * 0.5f + 0.5f) * QUANTIZATION_SCALE));
+	}
+	// the index of the largest component goes in the highest bits of the first two values
+	packed.data[0] |= (largest & 1) << 15;
+	packed.data[1] |= (largest >> 1) << 15;
+	return packed;
+}
+
+glm::quat UnpackQuat(PackedQuat packed)
+{
+	int largest = (packed.data[0] >> 15) | ((packed.data[1] >> 15) << 1);
+	float components[4];
+	float sum = 0.0f;
+	for (int i = 0, n = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		float value = (packed.data[n++] & 0x7fff) / QUANTIZATION_SCALE * 2.0f - 1.0f;
+		components[i] = value * SMALLEST_RANGE;
+		sum += components[i] * components[i];
+	}
+	components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+	return glm::quat(components[3], components[0], components[1], components[2]);
+}
+
+float GetAngleDegrees(const glm::quat& a, const glm::quat& b)
+{
+	// atan2 of the relative rotation, acos loses the small angles in float precision
+	glm::quat relative = glm::conjugate(glm::normalize(a)) * glm::normalize(b);
+	float sinHalfAngle = glm::length(glm::vec3(relative.x, relative.y, relative.z));
+	return glm::degrees(2.0f * std::atan2(sinHalfAngle, std::abs(relative.w)));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/quaternion.hpp>
+
+// import time compression of the keyframes of a clip
+struct KeyframeCompression
+{
+	bool enabled = false;
+	// max error allowed when removing keys, in model units
+	float positionTolerance = 0.001f;
+	// degrees
+	float rotationTolerance = 0.05f;
+	float scaleTolerance = 0.001f;
+	// store the rotations in 48 bits with the smallest three encoding
+	bool quantizeRotations = true;
+};
+
+// unit quaternion stored with its three smallest components (15 bits each) and the index of the largest one
+struct PackedQuat
+{
+	uint16_t data[3];
+};
+
+PackedQuat PackQuat(glm::quat q);
+glm::quat UnpackQuat(PackedQuat packed);
+float GetAngleDegrees(const glm::quat& a, const glm::quat& b);
+
+// longest run of keys removed in a row, it bounds the time spent checking a run
+constexpr int MAX_REMOVED_KEYS = 256;
+
+// removes the keys that the interpolation of the kept ones reproduces within the tolerance.
+// The error is measured against the original keys. If all the keys are within the tolerance
+// of the first one only that one is kept.
+template<typename Key, typename Lerp, typename Error>
+void ReduceKeys(std::vector<Key>& keys, float tolerance, Lerp lerp, Error error)
+{
+	if (keys.size() <= 1)
+		return;
+	bool constant = std::all_of(keys.begin() + 1, keys.end(), [&](const Key& key) { return error(keys[0], key) <= tolerance; });
+	if (constant)
+	{
+		keys.resize(1);
+		return;
+	}
+
+	std::vector<Key> kept;
+	kept.push_back(keys[0]);
+	int anchor = 0;
+	for (int i = 1; i + 1 < keys.size(); i++)
+	{
+		// can the segment anchor -> i + 1 replace the keys in between?
+		const Key& next = keys[i + 1];
+		bool removable = i - anchor < MAX_REMOVED_KEYS;
+		for (int j = anchor + 1; removable && j <= i; j++)
+		{
+			float factor = (keys[j].timeStamp - keys[anchor].timeStamp) / (next.timeStamp - keys[anchor].timeStamp);
+			removable = error(lerp(keys[anchor], next, factor), keys[j]) <= tolerance;
+		}
+		if (!removable)
+		{
+			kept.push_back(keys[i]);
+			anchor = i;
+		}
+	}
+	kept.push_back(keys.back());
+	keys = std::move(kept);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+
+#include <assimp/ProgressHandler.hpp>
+
+enum LoadStage
+{
+	Stage_Idle,
+	Stage_Parsing,
+	Stage_Propagating,
+	Stage_DecodingTextures,
+	Stage_LoadingAnimations,
+	Stage_Uploading,
+	Stage_Done
+};
+
+// progress of a load running on another thread. Written by the loading thread, read by the GUI.
+struct LoadProgress {
+	std::atomic<int> stage{ Stage_Idle };
+	std::atomic<int> done{ 0 };
+	std::atomic<int> total{ 0 };
+	std::atomic<bool> cancelled{ false };
+
+	void SetStage(LoadStage newStage, int numSteps)
+	{
+		total = numSteps;
+		done = 0;
+		stage = newStage;
+	}
+
+	void Step() { done++; }
+
+	float GetFraction() const
+	{
+		int t = total;
+		return t > 0 ? float(done) / float(t) : 0.0f;
+	}
+
+	static const char* GetStageName(int stage)
+	{
+		switch (stage) {
+		case Stage_Parsing: return "Parsing";
+		case Stage_Propagating: return "Propagating weights";
+		case Stage_DecodingTextures: return "Decoding textures";
+		case Stage_LoadingAnimations: return "Loading animations";
+		case Stage_Uploading: return "Uploading to GPU";
+		case Stage_Done: return "Done";
+		default: return "Idle";
+		}
+	}
+};
+
+// forwards the progress of an assimp import and aborts it when the load is cancelled
+class LoadProgressHandler : public Assimp::ProgressHandler {
+public:
+	LoadProgressHandler(LoadProgress& progress) : progress(progress) {}
+
+	bool Update(float percentage = -1.0f) override
+	{
+		if (percentage >= 0.0f)
+			progress.done = int(percentage * progress.total);
+		return !progress.cancelled;
+	}
+
+private:
+	LoadProgress& progress;
+};
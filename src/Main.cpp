@@ -53,11 +53,14 @@ int main()
 	{
 		// glfw: poll IO events(keys pressed / released, mouse moved etc.)
 		glfwPollEvents();
+		// handle the input received since the last frame at once
+		process_input(window);
 
 		status.Render();
 		RenderGUI(status);
 		// glfw: swap buffers
 		glfwSwapBuffers(window);
+		status.inputQueue.FramePresented(glfwGetTime());
 	}
 
 	// Clean memory
@@ -1,19 +1,18 @@
 #include "Mesh.h"
 
 // constructor
-Mesh::Mesh(std::vector<Vertex>&& vertices, std::vector<Face>&& faces, std::vector<int>&& texIndices)
+Mesh::Mesh(std::vector<Vertex>&& vertices, std::vector<Face>&& faces, std::vector<int>&& texIndices, bool propagateWeights, unsigned int propagationThreads)
 	:
 	vertices(std::move(vertices)),
 	faces(std::move(faces)),
 	texIndices(std::move(texIndices)),
 	enabled(true)
 {
-	// now that we have all the required data, set the vertex buffers and its attribute pointers.
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-	PropagateVerticesWeights();
-	SendMeshToGPU();
+	// vertices coming from a cooked model already hold the propagated weights
+	if (propagateWeights)
+		PropagateVerticesWeights(propagationThreads);
+	else
+		BuildTopology();
 }
 
 // copy constructor
@@ -21,44 +20,26 @@ Mesh::Mesh(const Mesh& m) :
 	vertices(m.vertices),
 	faces(m.faces),
 	texIndices(m.texIndices),
-	graph(m.graph),
+	topology(m.topology),
 	enabled(true)
 {
+	SetupGPU();
+}
+
+void Mesh::SetupGPU()
+{
+	// now that we have all the required data, set the vertex buffers and its attribute pointers.
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 	SendMeshToGPU();
 }
 
-void Mesh::Bake(std::vector<glm::mat4>& matrices, std::vector<Vertex>& animatedVertices)
-{
-	// Modify the vertex data
-	vertices.clear();
-	for (int i = 0; i < animatedVertices.size(); i++) {
-		Vertex& v = animatedVertices[i];
-		glm::mat4 cumulativeMatrix = glm::mat4(0.0f);
-		for (int i = 0; i < v.BoneData.NumBones; i++)
-		{
-			cumulativeMatrix += (v.BoneData.Weights[i] * matrices[v.BoneData.BoneIDs[i]]);
-		}
-		Vertex ver{};
-		ver.originalVertex = &animatedVertices[i];
-		ver.associatedWeightMatrix = cumulativeMatrix;
-		ver.Position = glm::vec3(cumulativeMatrix * glm::vec4(v.Position, 1.0f));
-		ver.Normal = glm::normalize(glm::vec3(cumulativeMatrix * glm::vec4(v.Normal, 0.0f)));
-		ver.Tangent = glm::normalize(glm::vec3(cumulativeMatrix * glm::vec4(v.Tangent, 0.0f)));
-		ver.Bitangent = glm::normalize(glm::vec3(cumulativeMatrix * glm::vec4(v.Bitangent, 0.0f)));
-		ver.TexCoords = v.TexCoords;
-		ver.BoneData.NumBones = 0;
-		vertices.push_back(ver);
-	}
-}
-
 // render the mesh
 void Mesh::Draw()
 {
 	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, faces.size() * sizeof(Face), GL_UNSIGNED_INT, 0);
+	glDrawElements(GL_TRIANGLES, faces.size() * 3, indexType, 0);
 
 	// always good practice to set everything back to defaults once configured.
 	glBindVertexArray(0);
@@ -66,9 +47,135 @@ void Mesh::Draw()
 }
 
 
-void Mesh::PropagateVerticesWeights()
+namespace {
+	struct BoneCandidate {
+		int boneID;
+		double weight;
+	};
+	// bones kept for each vertex while propagating: enough to pick MAX_BONE_INFLUENCE of them after skipping the original ones
+	constexpr int NUM_BONE_CANDIDATES = 2 * MAX_BONE_INFLUENCE;
+}
+
+void Mesh::PropagateBone(int boneID, const std::vector<int>& seeds, const std::vector<double>& edgeAttenuation, PropagationScratch& scratch) const
+{
+	const std::vector<int>& edgeStart = topology->offsets;
+	const std::vector<int>& edgeVertex = topology->neighbours;
+	std::vector<double>& weights = scratch.weights;
+	std::vector<int>& reached = scratch.reached;
+	std::priority_queue<std::pair<double, int>>& frontier = scratch.frontier;
+	for (int i : seeds) {
+		const Vertex& v = vertices[i];
+		for (int j = 0; j < v.BoneData.NumBones; j++)
+			if (v.BoneData.BoneIDs[j] == boneID)
+				weights[i] = abs(v.BoneData.Weights[j]);
+		//NOTE: we use abs because we are taking in consideration even meshes already modified with this tool
+		//      that could have some negative weights
+		reached.push_back(i);
+	}
+	for (int i : seeds)
+		if (weights[i] >= DBL_EPSILON)
+			frontier.emplace(weights[i], i);
+	// max-propagation: every vertex is expanded once with its final weight, the heaviest first
+	while (!frontier.empty()) {
+		auto [weight, i] = frontier.top();
+		frontier.pop();
+		if (weight < weights[i])
+			continue;
+		for (int e = edgeStart[i]; e < edgeStart[i + 1]; e++) {
+			int ver = edgeVertex[e];
+			double propagatedWeight = weight / edgeAttenuation[e];
+			if (propagatedWeight > weights[ver]) {
+				if (weights[ver] == 0.0)
+					reached.push_back(ver);
+				weights[ver] = propagatedWeight;
+				// weights this small are not propagated further
+				if (propagatedWeight >= DBL_EPSILON)
+					frontier.emplace(propagatedWeight, ver);
+			}
+		}
+	}
+}
+
+void Mesh::PropagateVerticesWeights(unsigned int numThreads)
+{
+	BuildTopology();
+	int numVertices = vertices.size();
+	if (numVertices == 0)
+		return;
+	float diag = GetDiagonalLenOfBoundingBox();
+	// attenuation of each edge of the adjacency, computed once instead of once per bone
+	std::vector<double> edgeAttenuation(topology->neighbours.size());
+	for (int i = 0; i < numVertices; i++) {
+		for (int e = topology->offsets[i]; e < topology->offsets[i + 1]; e++) {
+			double dist = glm::length(vertices[i].Position - vertices[topology->neighbours[e]].Position) / diag;
+			edgeAttenuation[e] = pow(1.1, dist);
+		}
+	}
+
+	// vertices originally influenced by each bone, ordered by bone id
+	std::map<int, std::vector<int>> seeds;
+	for (int i = 0; i < numVertices; i++)
+		for (int j = 0; j < vertices[i].BoneData.NumBones; j++)
+			seeds[vertices[i].BoneData.BoneIDs[j]].push_back(i);
+	std::vector<std::pair<int, const std::vector<int>*>> bones;
+	for (auto& [boneID, boneSeeds] : seeds)
+		bones.emplace_back(boneID, &boneSeeds);
+
+	// every bone is propagated independently. Bones are processed in batches, one per thread, and merged
+	// following the order of their ids, so the result doesn't depend on the number of threads.
+	ThreadPool& pool = ThreadPool::Instance();
+	int batchSize = std::min<int>(numThreads ? std::min(numThreads, pool.NumThreads()) : pool.NumThreads(), bones.size());
+	std::vector<PropagationScratch> scratch(std::max(batchSize, 1));
+	for (PropagationScratch& s : scratch)
+		s.weights.assign(numVertices, 0.0);
+
+	// best bones of each vertex by decreasing weight. Equal weights keep the lower bone id first, as the dense version does.
+	std::vector<BoneCandidate> candidates(numVertices * NUM_BONE_CANDIDATES, BoneCandidate{ -1, 0.0 });
+	for (int batchStart = 0; batchStart < bones.size(); batchStart += batchSize) {
+		int batchCount = std::min<int>(batchSize, bones.size() - batchStart);
+		pool.ParallelFor(batchCount, [&](int k) {
+			auto [boneID, boneSeeds] = bones[batchStart + k];
+			PropagateBone(boneID, *boneSeeds, edgeAttenuation, scratch[k]);
+			}, batchCount);
+		for (int k = 0; k < batchCount; k++) {
+			int boneID = bones[batchStart + k].first;
+			PropagationScratch& s = scratch[k];
+			for (int i : s.reached) {
+				double weight = s.weights[i];
+				s.weights[i] = 0.0;
+				if (weight < DBL_EPSILON)
+					continue;
+				BoneCandidate* best = &candidates[i * NUM_BONE_CANDIDATES];
+				int pos = 0;
+				while (pos < NUM_BONE_CANDIDATES && best[pos].weight >= weight)
+					pos++;
+				if (pos == NUM_BONE_CANDIDATES)
+					continue;
+				std::copy_backward(best + pos, best + NUM_BONE_CANDIDATES - 1, best + NUM_BONE_CANDIDATES);
+				best[pos] = BoneCandidate{ boneID, weight };
+			}
+			s.reached.clear();
+		}
+	}
+
+	// add new bones to the original ones
+	for (int i = 0; i < numVertices; i++) {
+		Vertex& v = vertices[i];
+		int numOriginalBones = v.BoneData.NumBones;
+		const BoneCandidate* best = &candidates[i * NUM_BONE_CANDIDATES];
+		for (int k = 0; k < NUM_BONE_CANDIDATES && v.BoneData.NumBones < MAX_BONE_INFLUENCE; k++) {
+			if (best[k].weight < DBL_EPSILON) break;
+			if (std::find(v.BoneData.BoneIDs, v.BoneData.BoneIDs + numOriginalBones, best[k].boneID) != v.BoneData.BoneIDs + numOriginalBones)
+				continue;
+			v.BoneData.BoneIDs[v.BoneData.NumBones] = best[k].boneID;
+			v.BoneData.Weights[v.BoneData.NumBones++] = 0.0f;
+		}
+	}
+}
+
+void Mesh::PropagateVerticesWeightsDense()
 {
-	BuildGraph();
+	BuildTopology();
 	// initialize the temp weights array [DENSE]
 	std::vector<std::vector<double>> weights = std::vector<std::vector<double>>(vertices.size(), std::vector<double>(MAX_NUM_BONE, 0.0));
 	for (int i = 0; i < vertices.size(); i++) {
@@ -88,7 +195,8 @@ void Mesh::PropagateVerticesWeights()
 			Vertex& v = vertices[i];
 			for (int j = 0; j < MAX_NUM_BONE; j++) {
 				if (weights[i][j] > -DBL_EPSILON && weights[i][j] < DBL_EPSILON) continue;
-				for (auto ver: graph[i]) {
+				for (const int* neighbour = topology->NeighboursBegin(i); neighbour != topology->NeighboursEnd(i); neighbour++) {
+					int ver = *neighbour;
 					// calculate the propagated weight
 					double dist = glm::length(v.Position - vertices[ver].Position) / diag;
 					double propagatedWeight = weights[i][j] / pow(1.1, dist);
@@ -120,64 +228,113 @@ void Mesh::PropagateVerticesWeights()
 	}
 }
 
-void Mesh::BuildGraph()
+void Mesh::BuildTopology()
 {
-	graph = std::vector<std::set<int>>(vertices.size(), std::set<int>());
-	for (Face& f : faces) {
-		//v1
-		graph[f.indices[0]].insert(f.indices[1]);
-		graph[f.indices[0]].insert(f.indices[2]);
-		//v2
-		graph[f.indices[1]].insert(f.indices[0]);
-		graph[f.indices[1]].insert(f.indices[2]);
-		//v3
-		graph[f.indices[2]].insert(f.indices[0]);
-		graph[f.indices[2]].insert(f.indices[1]);
-	}
+	topology = MeshTopology::Build(faces, vertices.size());
+}
+
+const MeshTopology& Mesh::GetTopology() const
+{
+	return *topology;
+}
+
+int Mesh::CountPropagationMismatches(std::vector<Vertex> originalVertices) const
+{
+	std::vector<Face> referenceFaces = faces;
+	Mesh reference(std::move(originalVertices), std::move(referenceFaces), std::vector<int>(), false);
+	reference.PropagateVerticesWeightsDense();
+	int mismatches = 0;
+	for (int i = 0; i < vertices.size(); i++)
+		if (!(reference.vertices[i].BoneData == vertices[i].BoneData))
+			mismatches++;
+	return mismatches;
 }
 
 // initializes all the buffer objects/arrays
 void Mesh::SendMeshToGPU()
 {
+	// the shaders only need a packed copy of the vertices, the editing data stays on the cpu
+	std::vector<RenderVertex> packedVertices;
+	PackVertices(vertices, packedVertices);
+	dirtyVertices.clear();
+
 	glBindVertexArray(VAO);
 	// load data into vertex buffers
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// A great thing about structs is that their memory layout is sequential for all its items.
-	// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-	// again translates to 3/2 floats which translates to a byte array.
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(RenderVertex), packedVertices.data(), GL_STATIC_DRAW);
+	gpuBytes = packedVertices.size() * sizeof(RenderVertex);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(Face), &faces[0], GL_STATIC_DRAW);
+	if (vertices.size() <= MAX_SHORT_INDEXED_VERTICES) {
+		std::vector<uint16_t> packedIndices;
+		PackShortIndices(faces, packedIndices);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, packedIndices.size() * sizeof(uint16_t), packedIndices.data(), GL_STATIC_DRAW);
+		indexType = GL_UNSIGNED_SHORT;
+		gpuBytes += packedIndices.size() * sizeof(uint16_t);
+	}
+	else {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(Face), faces.data(), GL_STATIC_DRAW);
+		indexType = GL_UNSIGNED_INT;
+		gpuBytes += faces.size() * sizeof(Face);
+	}
 
 	// set the vertex attribute pointers
 	// vertex Positions
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-	// vertex normals
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(RenderVertex), (void*)offsetof(RenderVertex, Position));
+	// vertex normals, octahedral encoded
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+	glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(RenderVertex), (void*)offsetof(RenderVertex, Normal));
 	// vertex texture coords
 	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-	// vertex tangent
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-	// vertex bitangent
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(RenderVertex), (void*)offsetof(RenderVertex, TexCoords));
+	// tangents and bitangents are not used by the shaders
+	glDisableVertexAttribArray(3);
+	glDisableVertexAttribArray(4);
 	// ids
 	glEnableVertexAttribArray(5);
-	glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, BoneData.BoneIDs[0]));
+	glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, sizeof(RenderVertex), (void*)offsetof(RenderVertex, BoneIDs));
 	// weights
 	glEnableVertexAttribArray(6);
-	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, BoneData.Weights[0]));
+	glVertexAttribPointer(6, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(RenderVertex), (void*)offsetof(RenderVertex, Weights));
 	// num bones
 	glEnableVertexAttribArray(7);
-	glVertexAttribIPointer(7, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, BoneData.NumBones));
+	glVertexAttribIPointer(7, 1, GL_UNSIGNED_BYTE, sizeof(RenderVertex), (void*)offsetof(RenderVertex, NumBones));
 	glBindVertexArray(0);
 }
 
+void Mesh::MarkDirty(int vertexIndex)
+{
+	dirtyVertices.push_back(vertexIndex);
+}
+
+size_t Mesh::UploadDirtyVertices()
+{
+	if (dirtyVertices.empty())
+		return 0;
+	std::sort(dirtyVertices.begin(), dirtyVertices.end());
+	dirtyVertices.erase(std::unique(dirtyVertices.begin(), dirtyVertices.end()), dirtyVertices.end());
+
+	size_t bytes = 0;
+	std::vector<RenderVertex> packedVertices;
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	for (int k = 0; k < dirtyVertices.size();) {
+		// runs separated by a few clean vertices are sent together, with one call
+		int first = dirtyVertices[k];
+		int last = first;
+		while (++k < dirtyVertices.size() && dirtyVertices[k] - last <= DIRTY_RUN_MAX_GAP + 1)
+			last = dirtyVertices[k];
+		packedVertices.resize(last - first + 1);
+		for (int i = first; i <= last; i++)
+			packedVertices[i - first] = PackVertex(vertices[i]);
+		glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(RenderVertex), packedVertices.size() * sizeof(RenderVertex), packedVertices.data());
+		bytes += packedVertices.size() * sizeof(RenderVertex);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	dirtyVertices.clear();
+	return bytes;
+}
+
 float Mesh::GetDiagonalLenOfBoundingBox()
 {
 	float minX = vertices[0].Position.x;
@@ -3,7 +3,10 @@
 #include "Shader.h"
 #include "Face.h"
 #include "Vertex.h"
+#include "RenderVertex.h"
 #include "TextureManager.h"
+#include "ThreadPool.h"
+#include "MeshTopology.h"
 
 //#include <glad/glad.h> // holds all OpenGL type declarations
 #include <glm/glm.hpp>
@@ -11,10 +14,13 @@
 
 #include <string>
 #include <vector>
-#include <set>
+#include <map>
+#include <queue>
 #include <algorithm>
 #include <cmath>
 
+// clean vertices sent along with the dirty ones around them instead of splitting the upload
+constexpr int DIRTY_RUN_MAX_GAP = 4;
 
 class Mesh {
 public:
@@ -23,30 +29,61 @@ public:
 	std::vector<Face> faces;
 	std::vector<int> texIndices;
 	// render data 
-	unsigned int VAO;
-	unsigned int VBO, EBO;
+	unsigned int VAO = 0;
+	unsigned int VBO = 0, EBO = 0;
+	// GL_UNSIGNED_SHORT when the vertices allow 16 bit indices
+	unsigned int indexType = 0;
+	// size of the vertex and index buffers
+	size_t gpuBytes = 0;
 	bool enabled = true;
 
 	// constructors
 	Mesh() = default;
-	Mesh(std::vector<Vertex>&& vertices, std::vector<Face>&& indices, std::vector<int>&& texIndices);
+	// only does CPU work, so it can run on any thread. SetupGPU must be called before drawing the mesh.
+	// propagationThreads limits the threads propagating the weights (0 = all of them).
+	Mesh(std::vector<Vertex>&& vertices, std::vector<Face>&& indices, std::vector<int>&& texIndices, bool propagateWeights = true, unsigned int propagationThreads = 0);
 	// copy constructor
 	Mesh(const Mesh& m);
 	// move constructor
 	Mesh(Mesh&& m) = default;
+	// move assignment
+	Mesh& operator=(Mesh&& m) = default;
 
 
-	// bake the mesh
-	void Bake(std::vector<glm::mat4>& matrices, std::vector<Vertex>& animatedVertices);
 	// render the mesh
 	void Draw();
-	// send opengl data for the mesh to the gpu
+	// generate the opengl objects of the mesh and send its data to the gpu. Must run on the thread owning the context
+	void SetupGPU();
+	// send opengl data for the mesh to the gpu, packed as RenderVertex
 	void SendMeshToGPU();
+	// the vertex changed since the last upload
+	void MarkDirty(int vertexIndex);
+	// sends again only the runs of dirty vertices, the index buffer and the attributes are kept. Returns the bytes uploaded
+	size_t UploadDirtyVertices();
+	// propagates the weights of the given vertices (as they were before the propagation) with the original dense
+	// algorithm and returns the number of vertices whose bones differ from the ones of this mesh
+	int CountPropagationMismatches(std::vector<Vertex> originalVertices) const;
+	const MeshTopology& GetTopology() const;
 
 private:
-	std::vector<std::set<int>> graph;
-	void BuildGraph();
+	// buffers used to propagate one bone, reused across bones
+	struct PropagationScratch {
+		// weight of the bone for each vertex, zero when not reached
+		std::vector<double> weights;
+		std::vector<int> reached;
+		std::priority_queue<std::pair<double, int>> frontier;
+	};
+
+	// vertices changed since the last upload, possibly repeated
+	std::vector<int> dirtyVertices;
+	// shared with the copies of the mesh, the faces of a baked mesh are the same
+	std::shared_ptr<const MeshTopology> topology;
+	void BuildTopology();
 	float GetDiagonalLenOfBoundingBox();
 	// propagate weights of the bones that influence the vertex to the next ones.
-	void PropagateVerticesWeights();
+	void PropagateVerticesWeights(unsigned int numThreads = 0);
+	// propagates a single bone from the vertices it influences, the result is left in the scratch buffers
+	void PropagateBone(int boneID, const std::vector<int>& seeds, const std::vector<double>& edgeAttenuation, PropagationScratch& scratch) const;
+	// reference implementation: fixed-point sweep over a dense vertices x bones matrix
+	void PropagateVerticesWeightsDense();
 };
\ No newline at end of file
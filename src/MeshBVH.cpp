@@ -0,0 +1,283 @@
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+
+namespace {
+	// deeper nodes become leaves, so the traversal stack has a fixed size
+	constexpr int BVH_MAX_DEPTH = 64;
+	// cost of visiting a node relative to testing a triangle
+	constexpr float BVH_TRAVERSAL_COST = 1.0f;
+	// boxes are slightly enlarged along the ray, the triangle test doesn't give exactly the same distances
+	constexpr float BVH_BOUNDS_TOLERANCE = 1.0001f;
+
+	struct Bounds {
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+
+		void Grow(glm::vec3 p)
+		{
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+
+		void Grow(const Bounds& b)
+		{
+			min = glm::min(min, b.min);
+			max = glm::max(max, b.max);
+		}
+
+		// half the surface area
+		float Area() const
+		{
+			if (min.x > max.x)
+				return 0.0f;
+			glm::vec3 e = max - min;
+			return e.x * e.y + e.y * e.z + e.z * e.x;
+		}
+	};
+
+	struct Bin {
+		Bounds bounds;
+		int count = 0;
+	};
+
+	int GetBin(float centroid, float minCentroid, float scale)
+	{
+		return std::min(BVH_NUM_BINS - 1, int((centroid - minCentroid) * scale));
+	}
+
+	// distance at which the ray enters the node, FLT_MAX if it misses it before maxDistance
+	float IntersectBounds(const BVHNode& node, glm::vec3 origin, glm::vec3 invDir, float maxDistance)
+	{
+		glm::vec3 t0 = (node.boundsMin - origin) * invDir;
+		glm::vec3 t1 = (node.boundsMax - origin) * invDir;
+		glm::vec3 tmin = glm::min(t0, t1);
+		glm::vec3 tmax = glm::max(t0, t1);
+		float tnear = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+		float tfar = std::min(std::min(tmax.x, tmax.y), tmax.z) * BVH_BOUNDS_TOLERANCE;
+		return tnear <= tfar && tnear <= maxDistance ? tnear : FLT_MAX;
+	}
+}
+
+void MeshBVH::Build(const std::vector<glm::vec3>& positions, const std::vector<Face>& faces)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	int numFaces = faces.size();
+	nodes.clear();
+	refitOrder.clear();
+	refitLevels.clear();
+	faceIndices.resize(numFaces);
+	std::iota(faceIndices.begin(), faceIndices.end(), 0);
+	if (numFaces == 0)
+		return;
+
+	std::vector<Bounds> faceBounds(numFaces);
+	std::vector<glm::vec3> centroids(numFaces);
+	for (int i = 0; i < numFaces; i++) {
+		for (unsigned int index : faces[i].indices)
+			faceBounds[i].Grow(positions[index]);
+		centroids[i] = (faceBounds[i].min + faceBounds[i].max) * 0.5f;
+	}
+
+	// a binary tree with numFaces leaves at most, so the nodes are never reallocated
+	nodes.reserve(2 * numFaces - 1);
+	nodes.push_back(BVHNode{ glm::vec3(0.0f), 0, glm::vec3(0.0f), numFaces });
+	std::vector<std::pair<int, int>> stack{ { 0, 0 } };
+	while (!stack.empty()) {
+		auto [nodeIndex, depth] = stack.back();
+		stack.pop_back();
+		BVHNode& node = nodes[nodeIndex];
+		Bounds bounds, centroidBounds;
+		for (int i = node.first; i < node.first + node.count; i++) {
+			bounds.Grow(faceBounds[faceIndices[i]]);
+			centroidBounds.Grow(centroids[faceIndices[i]]);
+		}
+		node.boundsMin = bounds.min;
+		node.boundsMax = bounds.max;
+		if (node.count <= BVH_MAX_LEAF_SIZE || depth >= BVH_MAX_DEPTH)
+			continue;
+
+		// binned surface area heuristic: cheapest split plane among the bin borders of the three axes
+		float bestCost = node.count * bounds.Area();
+		int bestAxis = -1, bestSplit = -1;
+		for (int axis = 0; axis < 3; axis++) {
+			float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+			if (extent <= 0.0f)
+				continue;
+			float scale = BVH_NUM_BINS / extent;
+			Bin bins[BVH_NUM_BINS];
+			for (int i = node.first; i < node.first + node.count; i++) {
+				int face = faceIndices[i];
+				Bin& bin = bins[GetBin(centroids[face][axis], centroidBounds.min[axis], scale)];
+				bin.count++;
+				bin.bounds.Grow(faceBounds[face]);
+			}
+			// split s puts the bins [0, s] on the left
+			float leftArea[BVH_NUM_BINS - 1], rightArea[BVH_NUM_BINS - 1];
+			int leftCount[BVH_NUM_BINS - 1], rightCount[BVH_NUM_BINS - 1];
+			Bounds left, right;
+			int numLeft = 0, numRight = 0;
+			for (int s = 0; s < BVH_NUM_BINS - 1; s++) {
+				numLeft += bins[s].count;
+				left.Grow(bins[s].bounds);
+				leftCount[s] = numLeft;
+				leftArea[s] = left.Area();
+				numRight += bins[BVH_NUM_BINS - 1 - s].count;
+				right.Grow(bins[BVH_NUM_BINS - 1 - s].bounds);
+				rightCount[BVH_NUM_BINS - 2 - s] = numRight;
+				rightArea[BVH_NUM_BINS - 2 - s] = right.Area();
+			}
+			for (int s = 0; s < BVH_NUM_BINS - 1; s++) {
+				if (leftCount[s] == 0 || rightCount[s] == 0)
+					continue;
+				float cost = BVH_TRAVERSAL_COST * bounds.Area() + leftCount[s] * leftArea[s] + rightCount[s] * rightArea[s];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = s;
+				}
+			}
+		}
+		// splitting is not worth it
+		if (bestAxis < 0)
+			continue;
+
+		float minCentroid = centroidBounds.min[bestAxis];
+		float scale = BVH_NUM_BINS / (centroidBounds.max[bestAxis] - minCentroid);
+		auto middle = std::partition(faceIndices.begin() + node.first, faceIndices.begin() + node.first + node.count, [&](int face) {
+			return GetBin(centroids[face][bestAxis], minCentroid, scale) <= bestSplit;
+			});
+		int leftCount = middle - (faceIndices.begin() + node.first);
+		int child = nodes.size();
+		nodes.push_back(BVHNode{ glm::vec3(0.0f), node.first, glm::vec3(0.0f), leftCount });
+		nodes.push_back(BVHNode{ glm::vec3(0.0f), node.first + leftCount, glm::vec3(0.0f), node.count - leftCount });
+		node.first = child;
+		node.count = 0;
+		stack.emplace_back(child, depth + 1);
+		stack.emplace_back(child + 1, depth + 1);
+	}
+
+	// the triangles of a leaf are tested in order, so that equal distances keep the lowest face index
+	triangles.Resize(numFaces);
+	for (const BVHNode& node : nodes) {
+		if (node.count == 0)
+			continue;
+		std::sort(faceIndices.begin() + node.first, faceIndices.begin() + node.first + node.count);
+		for (int i = node.first; i < node.first + node.count; i++) {
+			const Face& f = faces[faceIndices[i]];
+			triangles.Set(i, positions[f.indices[0]], positions[f.indices[1]], positions[f.indices[2]]);
+		}
+	}
+
+	// children always follow their parent, so the heights are computed backwards
+	std::vector<int> heights(nodes.size(), 0);
+	int maxHeight = 0;
+	for (int i = int(nodes.size()) - 1; i >= 0; i--) {
+		if (nodes[i].count == 0)
+			heights[i] = 1 + std::max(heights[nodes[i].first], heights[nodes[i].first + 1]);
+		maxHeight = std::max(maxHeight, heights[i]);
+	}
+	refitLevels.assign(maxHeight + 2, 0);
+	for (int height : heights)
+		refitLevels[height + 1]++;
+	for (int level = 1; level < refitLevels.size(); level++)
+		refitLevels[level] += refitLevels[level - 1];
+	refitOrder.resize(nodes.size());
+	std::vector<int> next(refitLevels.begin(), refitLevels.end() - 1);
+	for (int i = 0; i < nodes.size(); i++)
+		refitOrder[next[heights[i]]++] = i;
+	buildTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void MeshBVH::Refit(const std::vector<glm::vec3>& positions, const std::vector<Face>& faces, unsigned int numThreads)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int level = 0; level + 1 < refitLevels.size(); level++) {
+		int begin = refitLevels[level], end = refitLevels[level + 1];
+		int numChunks = (end - begin + BVH_REFIT_CHUNK_SIZE - 1) / BVH_REFIT_CHUNK_SIZE;
+		ThreadPool::Instance().ParallelFor(numChunks, [&](int chunk) {
+			int chunkEnd = std::min(end, begin + (chunk + 1) * BVH_REFIT_CHUNK_SIZE);
+			for (int i = begin + chunk * BVH_REFIT_CHUNK_SIZE; i < chunkEnd; i++) {
+				BVHNode& node = nodes[refitOrder[i]];
+				Bounds bounds;
+				if (node.count > 0) {
+					for (int f = node.first; f < node.first + node.count; f++) {
+						const Face& face = faces[faceIndices[f]];
+						const glm::vec3& v0 = positions[face.indices[0]];
+						const glm::vec3& v1 = positions[face.indices[1]];
+						const glm::vec3& v2 = positions[face.indices[2]];
+						bounds.Grow(v0);
+						bounds.Grow(v1);
+						bounds.Grow(v2);
+						triangles.Set(f, v0, v1, v2);
+					}
+				}
+				else {
+					for (int c = node.first; c < node.first + 2; c++) {
+						bounds.Grow(nodes[c].boundsMin);
+						bounds.Grow(nodes[c].boundsMax);
+					}
+				}
+				node.boundsMin = bounds.min;
+				node.boundsMax = bounds.max;
+			}
+			}, numThreads);
+	}
+	refitTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+BVHHit MeshBVH::Intersect(glm::vec3 origin, glm::vec3 dir, int& trianglesTested, TrianglePath path) const
+{
+	BVHHit hit;
+	if (nodes.empty())
+		return hit;
+	glm::vec3 invDir = 1.0f / dir;
+	// nodes to visit with the distance at which the ray enters them
+	std::pair<int, float> stack[BVH_MAX_DEPTH + 2];
+	int size = 0;
+	float rootDistance = IntersectBounds(nodes[0], origin, invDir, hit.distance);
+	if (rootDistance != FLT_MAX)
+		stack[size++] = { 0, rootDistance };
+	while (size > 0) {
+		auto [nodeIndex, distance] = stack[--size];
+		if (distance > hit.distance)
+			continue;
+		const BVHNode& node = nodes[nodeIndex];
+		if (node.count > 0) {
+			trianglesTested += node.count;
+			// hits at the current distance as well, the lowest face index wins
+			TriangleHit leafHit;
+			leafHit.distance = hit.distance;
+			if (IntersectTriangles(triangles, origin, dir, node.first, node.first + node.count, leafHit, path)) {
+				int face = faceIndices[leafHit.index];
+				if (leafHit.distance < hit.distance || hit.face < 0 || face < hit.face) {
+					hit.face = face;
+					hit.distance = leafHit.distance;
+					hit.point = origin + leafHit.distance * dir;
+					hit.barycentrics = glm::vec2(leafHit.u, leafHit.v);
+				}
+			}
+			continue;
+		}
+		// the nearest child is visited first
+		float d0 = IntersectBounds(nodes[node.first], origin, invDir, hit.distance);
+		float d1 = IntersectBounds(nodes[node.first + 1], origin, invDir, hit.distance);
+		std::pair<int, float> nearChild{ node.first, d0 }, farChild{ node.first + 1, d1 };
+		if (d1 < d0)
+			std::swap(nearChild, farChild);
+		if (farChild.second != FLT_MAX)
+			stack[size++] = farChild;
+		if (nearChild.second != FLT_MAX)
+			stack[size++] = nearChild;
+	}
+	return hit;
+}
+
+size_t MeshBVH::GetMemoryBytes() const
+{
+	return nodes.size() * sizeof(BVHNode) + (faceIndices.size() + refitOrder.size() + refitLevels.size()) * sizeof(int)
+		+ triangles.GetMemoryBytes();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Face.h"
+#include "TriangleKernel.h"
+
+#include <vector>
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+// nodes with this many triangles or less are not split
+constexpr int BVH_MAX_LEAF_SIZE = 4;
+// candidate split planes per axis evaluated with the surface area heuristic
+constexpr int BVH_NUM_BINS = 16;
+// nodes refitted by a single task
+constexpr int BVH_REFIT_CHUNK_SIZE = 4096;
+
+struct BVHNode {
+	glm::vec3 boundsMin;
+	// first child (the second one follows it) or first triangle of a leaf
+	int first;
+	glm::vec3 boundsMax;
+	// triangles of a leaf, 0 for inner nodes
+	int count;
+};
+
+struct BVHHit {
+	int face = -1;
+	float distance = FLT_MAX;
+	glm::vec3 point = glm::vec3(0.0f);
+	// weights of the second and third vertex of the face
+	glm::vec2 barycentrics = glm::vec2(0.0f);
+};
+
+// bounding volume hierarchy over the triangles of a mesh, built with the surface area heuristic
+class MeshBVH {
+public:
+	std::vector<BVHNode> nodes;
+	// faces ordered so that every leaf refers to a contiguous range of them, by index inside a leaf
+	std::vector<int> faceIndices;
+	// triangles of the faces in the same order, tested a packet at a time
+	PackedTriangles triangles;
+	// nodes ordered by height (leaves first), every level only depends on the previous ones
+	std::vector<int> refitOrder;
+	// start of each level in refitOrder, plus the end of the last one
+	std::vector<int> refitLevels;
+	// time spent by the last build (ms)
+	float buildTime = 0.0f;
+	// time spent by the last refit (ms)
+	float refitTime = 0.0f;
+
+	void Build(const std::vector<glm::vec3>& positions, const std::vector<Face>& faces);
+	// recomputes the bounds of the nodes for the moved positions, keeping the same tree.
+	// The nodes of each level are refitted in parallel by numThreads threads (0 = all of them).
+	void Refit(const std::vector<glm::vec3>& positions, const std::vector<Face>& faces, unsigned int numThreads = 0);
+	// closest triangle hit farther than FLT_EPSILON along the ray, equal distances keep the lowest face index.
+	// trianglesTested is increased by the number of ray-triangle tests
+	BVHHit Intersect(glm::vec3 origin, glm::vec3 dir, int& trianglesTested, TrianglePath path = GetBestTrianglePath()) const;
+	size_t GetMemoryBytes() const;
+};
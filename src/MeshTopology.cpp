@@ -0,0 +1,128 @@
+#include "MeshTopology.h"
+#include "ThreadPool.h"
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+namespace {
+	// vertices sorted and deduplicated by each job of the parallel passes
+	constexpr int TOPOLOGY_CHUNK = 4096;
+
+	int NumChunks(int count) { return (count + TOPOLOGY_CHUNK - 1) / TOPOLOGY_CHUNK; }
+
+	// offsets of a csr table from the number of entries of each row
+	void PrefixSum(const std::vector<int>& counts, std::vector<int>& offsets)
+	{
+		offsets.resize(counts.size() + 1);
+		offsets[0] = 0;
+		for (int i = 0; i < counts.size(); i++)
+			offsets[i + 1] = offsets[i] + counts[i];
+	}
+}
+
+std::shared_ptr<const MeshTopology> MeshTopology::Build(const std::vector<Face>& faces, int numVertices, bool buildEdges, bool buildFaceAdjacency)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	auto topology = std::make_shared<MeshTopology>();
+	ThreadPool& pool = ThreadPool::Instance();
+
+	// every corner of a face adds its two neighbours, duplicates included
+	std::vector<int> counts(numVertices, 0);
+	for (const Face& f : faces)
+		for (int k = 0; k < 3; k++)
+			counts[f.indices[k]] += 2;
+	std::vector<int> rawOffsets;
+	PrefixSum(counts, rawOffsets);
+	std::vector<int> raw(rawOffsets[numVertices]);
+	std::vector<int> cursor(rawOffsets.begin(), rawOffsets.end() - 1);
+	for (const Face& f : faces)
+		for (int k = 0; k < 3; k++) {
+			int v = f.indices[k];
+			raw[cursor[v]++] = f.indices[(k + 1) % 3];
+			raw[cursor[v]++] = f.indices[(k + 2) % 3];
+		}
+
+	// sort and remove the duplicates of each row
+	pool.ParallelFor(NumChunks(numVertices), [&](int chunk) {
+		int end = std::min(numVertices, (chunk + 1) * TOPOLOGY_CHUNK);
+		for (int v = chunk * TOPOLOGY_CHUNK; v < end; v++) {
+			int* begin = raw.data() + rawOffsets[v];
+			std::sort(begin, raw.data() + rawOffsets[v + 1]);
+			counts[v] = std::unique(begin, raw.data() + rawOffsets[v + 1]) - begin;
+		}
+		});
+	PrefixSum(counts, topology->offsets);
+	topology->neighbours.resize(topology->offsets[numVertices]);
+	pool.ParallelFor(NumChunks(numVertices), [&](int chunk) {
+		int end = std::min(numVertices, (chunk + 1) * TOPOLOGY_CHUNK);
+		for (int v = chunk * TOPOLOGY_CHUNK; v < end; v++)
+			std::copy_n(raw.data() + rawOffsets[v], counts[v], topology->neighbours.data() + topology->offsets[v]);
+		});
+
+	if (buildEdges) {
+		topology->edges.reserve(topology->neighbours.size() / 2);
+		for (int v = 0; v < numVertices; v++)
+			for (const int* n = topology->NeighboursBegin(v); n != topology->NeighboursEnd(v); n++)
+				if (v < *n)
+					topology->edges.push_back(Edge{ v, *n });
+	}
+
+	if (buildFaceAdjacency) {
+		// faces around each vertex
+		std::fill(counts.begin(), counts.end(), 0);
+		for (const Face& f : faces)
+			for (int k = 0; k < 3; k++)
+				counts[f.indices[k]]++;
+		std::vector<int> faceOffsets;
+		PrefixSum(counts, faceOffsets);
+		std::vector<int> vertexFaces(faceOffsets[numVertices]);
+		std::copy(faceOffsets.begin(), faceOffsets.end() - 1, cursor.begin());
+		for (int f = 0; f < faces.size(); f++)
+			for (int k = 0; k < 3; k++)
+				vertexFaces[cursor[faces[f].indices[k]]++] = f;
+
+		int numFaces = faces.size();
+		topology->faceAdjacency.assign(3 * numFaces, -1);
+		pool.ParallelFor(NumChunks(numFaces), [&](int chunk) {
+			int end = std::min(numFaces, (chunk + 1) * TOPOLOGY_CHUNK);
+			for (int f = chunk * TOPOLOGY_CHUNK; f < end; f++)
+				for (int k = 0; k < 3; k++) {
+					unsigned int a = faces[f].indices[k], b = faces[f].indices[(k + 1) % 3];
+					for (int i = faceOffsets[a]; i < faceOffsets[a + 1]; i++) {
+						const Face& other = faces[vertexFaces[i]];
+						if (vertexFaces[i] != f && std::find(other.indices.begin(), other.indices.end(), b) != other.indices.end()) {
+							topology->faceAdjacency[3 * f + k] = vertexFaces[i];
+							break;
+						}
+					}
+				}
+			});
+	}
+
+	topology->buildTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return topology;
+}
+
+size_t MeshTopology::GetMemoryBytes() const
+{
+	return offsets.capacity() * sizeof(int) + neighbours.capacity() * sizeof(int)
+		+ edges.capacity() * sizeof(Edge) + faceAdjacency.capacity() * sizeof(int);
+}
+
+void MeshTopology::MeasureSetGraph(const std::vector<Face>& faces, int numVertices, size_t& bytes, float& time)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	size_t bytesBefore = AllocationCounter::GetThreadAllocatedBytes();
+	{
+		std::vector<std::set<int>> graph(numVertices);
+		for (const Face& f : faces)
+			for (int k = 0; k < 3; k++) {
+				graph[f.indices[k]].insert(f.indices[(k + 1) % 3]);
+				graph[f.indices[k]].insert(f.indices[(k + 2) % 3]);
+			}
+		bytes = AllocationCounter::GetThreadAllocatedBytes() - bytesBefore;
+		time = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
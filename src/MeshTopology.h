@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Face.h"
+
+#include <vector>
+#include <memory>
+
+// unique undirected edge, v0 < v1
+struct Edge {
+	int v0;
+	int v1;
+};
+
+// vertex adjacency of a mesh in compressed sparse row form: the neighbours of vertex i are
+// neighbours[offsets[i]] ... neighbours[offsets[i + 1] - 1], sorted by index.
+// It never changes once built, so the animated and the baked meshes share it.
+struct MeshTopology {
+	std::vector<int> offsets;
+	std::vector<int> neighbours;
+	// optional tables
+	std::vector<Edge> edges;
+	// face across each edge of a face: faceAdjacency[3 * f + k] is the face sharing the edge from
+	// indices[k] to indices[(k + 1) % 3] of face f, -1 on the border
+	std::vector<int> faceAdjacency;
+	// time spent building the tables (ms)
+	float buildTime = 0.0f;
+
+	static std::shared_ptr<const MeshTopology> Build(const std::vector<Face>& faces, int numVertices, bool buildEdges = false, bool buildFaceAdjacency = false);
+
+	int NumVertices() const { return int(offsets.size()) - 1; }
+	const int* NeighboursBegin(int vertex) const { return neighbours.data() + offsets[vertex]; }
+	const int* NeighboursEnd(int vertex) const { return neighbours.data() + offsets[vertex + 1]; }
+	size_t GetMemoryBytes() const;
+
+	// builds the std::set based graph used before, to compare memory (bytes requested to the allocator) and time
+	static void MeasureSetGraph(const std::vector<Face>& faces, int numVertices, size_t& bytes, float& time);
+};
@@ -1,20 +1,183 @@
 #include "Model.h"
 
 // constructor, expects a filepath to a 3D model.
-Model::Model(std::string& path, TextureManager& texManager, bool gamma)
+Model::Model(std::string& path, TextureManager& texManager, const ModelLoadOptions& options, bool gamma)
 	:
 	gammaCorrection(gamma),
 	texMan(texManager)
 {
-	loadModel(path);
+	loadModel(path, options);
 }
 
-Model Model::Bake(std::vector<glm::mat4>& matrices)
+Model::Model(Model&& m, TextureManager& texManager)
+	:
+	meshes(std::move(m.meshes)),
+	directory(std::move(m.directory)),
+	texMan(texManager),
+	gammaCorrection(m.gammaCorrection),
+	loadedFromCache(m.loadedFromCache),
+	loadTime(m.loadTime),
+	importTime(m.importTime),
+	m_BoneInfoMap(std::move(m.m_BoneInfoMap)),
+	m_BoneCounter(m.m_BoneCounter)
+{}
+
+BakedModel Model::Bake(std::vector<glm::mat4>& matrices, SkinningPath path, unsigned int numThreads)
+{
+	BakedModel baked;
+	Rebake(baked, matrices, path, numThreads);
+	return baked;
+}
+
+void Model::Rebake(BakedModel& baked, std::vector<glm::mat4>& matrices, SkinningPath path, unsigned int numThreads)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	BakeMeshes(baked.meshes, meshes, matrices, path, numThreads);
+	baked.bakeTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void Model::BakeMeshes(std::vector<BakedMesh>& baked, std::vector<Mesh>& animated, std::vector<glm::mat4>& matrices, SkinningPath path, unsigned int numThreads)
+{
+	// every mesh is split in chunks of vertices, the chunks of all the meshes are baked in parallel.
+	// Each chunk writes its own range of the preallocated baked arrays.
+	struct BakeTask {
+		int mesh;
+		int begin;
+		int end;
+	};
+	std::vector<BakeTask> tasks;
+	baked.resize(animated.size());
+	for (int i = 0; i < animated.size(); i++) {
+		baked[i].Prepare(animated[i]);
+		int numVertices = animated[i].vertices.size();
+		for (int begin = 0; begin < numVertices; begin += BAKE_CHUNK_SIZE)
+			tasks.push_back(BakeTask{ i, begin, std::min(begin + BAKE_CHUNK_SIZE, numVertices) });
+	}
+	ThreadPool::Instance().ParallelFor(tasks.size(), [&](int t) {
+		const BakeTask& task = tasks[t];
+		baked[task.mesh].BakeRange(matrices, task.begin, task.end, path);
+		}, numThreads);
+}
+
+std::vector<BakeScalingTiming> Model::BenchmarkBakeScaling(int numVertices)
+{
+	constexpr int NUM_MESHES = 4;
+	constexpr int NUM_RUNS = 3;
+	// random rigid bones and vertices influenced by MAX_BONE_INFLUENCE of them
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	std::vector<glm::mat4> matrices(MAX_NUM_BONE);
+	for (glm::mat4& m : matrices) {
+		glm::vec3 axis = glm::normalize(glm::vec3(uniform(random), uniform(random), 1.0f));
+		m = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(uniform(random), uniform(random), uniform(random))), uniform(random) * glm::pi<float>(), axis);
+	}
+	std::vector<Mesh> animated(NUM_MESHES);
+	for (int i = 0; i < NUM_MESHES; i++) {
+		animated[i].vertices.resize(numVertices / NUM_MESHES + (i < numVertices % NUM_MESHES ? 1 : 0));
+		for (Vertex& v : animated[i].vertices) {
+			v.Position = glm::vec3(uniform(random), uniform(random), uniform(random));
+			v.Normal = glm::normalize(glm::vec3(uniform(random), uniform(random), 1.0f));
+			v.BoneData.NumBones = MAX_BONE_INFLUENCE;
+			for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+				v.BoneData.BoneIDs[k] = random() % MAX_NUM_BONE;
+				v.BoneData.Weights[k] = 1.0f / MAX_BONE_INFLUENCE;
+			}
+		}
+	}
+
+	std::vector<BakeScalingTiming> timings;
+	std::vector<BakedMesh> baked;
+	unsigned int maxThreads = ThreadPool::Instance().NumThreads();
+	for (unsigned int numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads)) {
+		float best = FLT_MAX;
+		for (int run = 0; run < NUM_RUNS; run++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			BakeMeshes(baked, animated, matrices, GetBestSkinningPath(), numThreads);
+			best = std::min(best, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		std::cout << "Bake of " << numVertices << " vertices with " << numThreads << " threads: " << best << " ms\n";
+		timings.push_back(BakeScalingTiming{ numThreads, best });
+		if (numThreads == maxThreads)
+			break;
+	}
+	return timings;
+}
+
+std::vector<BakeTiming> Model::BenchmarkBake(std::vector<glm::mat4>& matrices)
+{
+	// best of a few runs, the first one also warms up the caches
+	constexpr int NUM_RUNS = 5;
+	std::vector<BakeTiming> timings;
+	std::vector<BakedMesh> reference;
+	std::vector<BakedMesh> baked;
+	for (int p = 0; p < Skinning_NumPaths; p++) {
+		SkinningPath path = SkinningPath(p);
+		if (!IsSkinningPathSupported(path))
+			continue;
+		std::vector<BakedMesh>& target = path == Skinning_Scalar ? reference : baked;
+		float best = FLT_MAX;
+		for (int run = 0; run < NUM_RUNS; run++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			// a single thread, to compare the kernels
+			BakeMeshes(target, meshes, matrices, path, 1);
+			best = std::min(best, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		float maxError = 0.0f;
+		for (int i = 0; i < meshes.size(); i++) {
+			for (int v = 0; v < meshes[i].vertices.size(); v++) {
+				// vertices without bones have a degenerate normal on every path
+				if (meshes[i].vertices[v].BoneData.NumBones == 0)
+					continue;
+				glm::vec3 positionError = glm::abs(target[i].positions[v] - reference[i].positions[v]);
+				glm::vec3 normalError = glm::abs(target[i].normals[v] - reference[i].normals[v]);
+				maxError = std::max({ maxError, positionError.x, positionError.y, positionError.z, normalError.x, normalError.y, normalError.z });
+			}
+		}
+		std::cout << "Bake " << GetSkinningPathName(path) << ": " << best << " ms, max error " << maxError << "\n";
+		timings.push_back(BakeTiming{ path, best, maxError });
+	}
+	return timings;
+}
+
+std::vector<PropagationTiming> Model::BenchmarkPropagation() const
 {
-	Model m(*this);
+	// the bones added by the propagation have weight 0, removing them gives back the imported vertices
+	std::vector<std::vector<Vertex>> importedVertices(meshes.size());
 	for (int i = 0; i < meshes.size(); i++)
-		m.meshes[i].Bake(matrices, meshes[i].vertices);
-	return m;
+	{
+		importedVertices[i] = meshes[i].vertices;
+		for (Vertex& v : importedVertices[i])
+			while (v.BoneData.NumBones > 0 && v.BoneData.Weights[v.BoneData.NumBones - 1] == 0.0f)
+				v.BoneData.NumBones--;
+	}
+
+	std::vector<PropagationTiming> timings;
+	std::vector<Mesh> reference;
+	unsigned int maxThreads = ThreadPool::Instance().NumThreads();
+	for (unsigned int numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+	{
+		std::vector<Mesh> propagated;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < meshes.size(); i++)
+		{
+			std::vector<Vertex> vertices = importedVertices[i];
+			std::vector<Face> faces = meshes[i].faces;
+			propagated.emplace_back(std::move(vertices), std::move(faces), std::vector<int>(), true, numThreads);
+		}
+		float time = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (reference.empty())
+			reference = std::move(propagated);
+		int mismatches = 0;
+		for (int i = 0; i < propagated.size(); i++)
+			for (int v = 0; v < propagated[i].vertices.size(); v++)
+				if (!(propagated[i].vertices[v].BoneData == reference[i].vertices[v].BoneData))
+					mismatches++;
+		timings.push_back({ numThreads, time, mismatches });
+		std::cout << "Propagation with " << numThreads << " threads: " << time << " ms, " << mismatches << " mismatches\n";
+		if (numThreads == maxThreads)
+			break;
+	}
+	return timings;
 }
 
 // draws the model, and thus all its meshes
@@ -47,80 +210,202 @@ int Model::AddBoneInfo(std::string&& name, glm::mat4 offset)
 
 void Model::Reload()
 {
+	auto start = std::chrono::high_resolution_clock::now();
 	for (Mesh& m : meshes) {
 		m.SendMeshToGPU();
 	}
+	reloadTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void Model::UploadDirtyVertices()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	uploadBytes = 0;
+	for (Mesh& m : meshes)
+		uploadBytes += m.UploadDirtyVertices();
+	uploadTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+size_t Model::GetGPUBytes() const
+{
+	size_t bytes = 0;
+	for (const Mesh& m : meshes)
+		bytes += m.gpuBytes;
+	return bytes;
+}
+
+void Model::SetupGPU()
+{
+	for (Mesh& m : meshes) {
+		if (m.VAO == 0)
+			m.SetupGPU();
+	}
 }
 
 std::map<std::string, BoneInfo> Model::GetBoneInfoMap() { return m_BoneInfoMap; }
 
 // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-void Model::loadModel(std::string& path)
+void Model::loadModel(std::string& path, const ModelLoadOptions& options)
 {
+	auto start = std::chrono::high_resolution_clock::now();
+	auto elapsedMs = [&start]() {
+		return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	};
+	// retrieve the directory path of the filepath
+	std::replace(path.begin(), path.end(), '\\', '/');
+	directory = path.substr(0, path.find_last_of('/'));
+
+	// try the cooked model first
+	uint64_t sourceHash = 0;
+	std::string cachePath = ModelCache::GetCachePath(path);
+	if (options.useCache)
+	{
+		if (options.progress) options.progress->SetStage(Stage_Parsing, 0);
+		sourceHash = ModelCache::HashFile(path);
+		CookedModel cooked;
+		if (sourceHash && ModelCache::Read(cachePath, sourceHash, MODEL_IMPORT_FLAGS, cooked))
+		{
+			importTime = cooked.importTime;
+			loadCookedModel(std::move(cooked), options);
+			loadedFromCache = true;
+			loadTime = elapsedMs();
+			std::cout << "Model loaded from cache in " << loadTime << " ms (assimp: " << importTime << " ms)\n";
+			return;
+		}
+	}
+
 	// read file via ASSIMP
 	Assimp::Importer importer;
 	importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, aiComponent_CAMERAS | aiComponent_COLORS | aiComponent_LIGHTS);
 	importer.SetPropertyInteger(AI_CONFIG_PP_FD_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
-	const aiScene* scene = importer.ReadFile(path,
-		aiProcess_Triangulate |
-		aiProcess_ImproveCacheLocality |
-		aiProcess_RemoveRedundantMaterials |
-		aiProcess_RemoveComponent |
-		aiProcess_GenUVCoords |
-		aiProcess_SortByPType |
-		aiProcess_FindDegenerates |
-		aiProcess_FindInstances |
-		aiProcess_ValidateDataStructure |
-		aiProcess_OptimizeMeshes |
-		aiProcess_OptimizeGraph |
-		aiProcess_FixInfacingNormals |
-		aiProcess_JoinIdenticalVertices
-	);
+	if (options.progress)
+	{
+		options.progress->SetStage(Stage_Parsing, 100);
+		// the importer takes ownership of the handler
+		importer.SetProgressHandler(new LoadProgressHandler(*options.progress));
+	}
+	const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+	if (options.progress && options.progress->cancelled)
+		return;
 	// check for errors
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
 	{
 		std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
 		return;
 	}
-	// retrieve the directory path of the filepath
-	std::replace(path.begin(), path.end(), '\\', '/');
-	directory = path.substr(0, path.find_last_of('/'));
 	// process ASSIMP's root node recursively
-	processNode(scene->mRootNode, scene);
+	std::vector<aiMesh*> sceneMeshes;
+	processNode(scene->mRootNode, scene, sceneMeshes);
+	processMeshes(sceneMeshes, scene, options);
+	if (options.progress && options.progress->cancelled)
+		return;
+	loadTime = importTime = elapsedMs();
+	std::cout << "Model loaded with assimp in " << loadTime << " ms\n";
+
+	if (options.useCache && sourceHash && !ModelCache::Write(cachePath, sourceHash, MODEL_IMPORT_FLAGS, cookModel()))
+		std::cout << "Failed to write the model cache at path: " << cachePath << "\n";
 }
 
-// processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::loadCookedModel(CookedModel&& cooked, const ModelLoadOptions& options)
 {
-	// process each mesh located at the current node
+	m_BoneInfoMap = std::move(cooked.boneInfoMap);
+	m_BoneCounter = cooked.boneCounter;
+	int numMeshes = cooked.meshes.size();
+	std::vector<Mesh> cookedMeshes(numMeshes);
+	ThreadPool::Instance().ParallelFor(numMeshes, [&](int i) {
+		CookedMesh& m = cooked.meshes[i];
+		cookedMeshes[i] = Mesh(std::move(m.vertices), std::move(m.faces), std::vector<int>(), false);
+		});
+	if (options.progress) options.progress->SetStage(Stage_DecodingTextures, numMeshes);
+	for (int i = 0; i < numMeshes; i++)
+	{
+		if (options.progress && options.progress->cancelled) return;
+		for (CookedTexture& tex : cooked.meshes[i].textures)
+			cookedMeshes[i].texIndices.push_back(texMan.LoadTextureFromFile(tex.path.c_str(), tex.type));
+		if (options.progress) options.progress->Step();
+	}
+	meshes.reserve(meshes.size() + numMeshes);
+	for (Mesh& m : cookedMeshes)
+	{
+		if (!options.deferGPUSetup)
+			m.SetupGPU();
+		meshes.push_back(std::move(m));
+	}
+}
+
+CookedModel Model::cookModel()
+{
+	CookedModel cooked;
+	cooked.boneInfoMap = m_BoneInfoMap;
+	cooked.boneCounter = m_BoneCounter;
+	cooked.importTime = importTime;
+	cooked.meshes.reserve(meshes.size());
+	for (Mesh& m : meshes)
+	{
+		CookedMesh cookedMesh;
+		cookedMesh.vertices = m.vertices;
+		cookedMesh.faces = m.faces;
+		for (int texIndex : m.texIndices)
+			cookedMesh.textures.push_back(CookedTexture{ texMan.textures[texIndex].type, texMan.textures[texIndex].path });
+		cooked.meshes.push_back(std::move(cookedMesh));
+	}
+	return cooked;
+}
+
+// processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+void Model::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sceneMeshes)
+{
+	// collect each mesh located at the current node
 	for (unsigned int i = 0; i < node->mNumMeshes; i++)
 	{
 		// the node object only contains indices to index the actual objects in the scene. 
 		// the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.push_back(processMesh(mesh, scene));
+		sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 	}
-	// after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+	// after we've collected all of the meshes (if any) we then recursively process each of the children nodes
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
 	{
-		processNode(node->mChildren[i], scene);
+		processNode(node->mChildren[i], scene, sceneMeshes);
 	}
 
 }
 
-void Model::SetVertexBoneDataToDefault(Vertex& vertex)
+void Model::processMeshes(const std::vector<aiMesh*>& sceneMeshes, const aiScene* scene, const ModelLoadOptions& options)
 {
-	vertex.BoneData.NumBones = 0;
-	vertex.BoneData.BoneIDs[0] = -1;
-	vertex.BoneData.Weights[0] = 0.0f;
+	LoadProgress* progress = options.progress;
+	int numMeshes = sceneMeshes.size();
+	// bone IDs must not depend on the scheduling of the threads, so they are registered serially following the order of the hierarchy
+	std::vector<std::vector<int>> boneIDs(numMeshes);
+	for (int i = 0; i < numMeshes; i++)
+		boneIDs[i] = registerMeshBones(sceneMeshes[i]);
+	// vertex conversion and weight propagation are independent across meshes
+	if (progress) progress->SetStage(Stage_Propagating, numMeshes);
+	std::vector<Mesh> processedMeshes(numMeshes);
+	ThreadPool::Instance().ParallelFor(numMeshes, [&](int i) {
+		if (progress && progress->cancelled) return;
+		processedMeshes[i] = processMesh(sceneMeshes[i], std::vector<int>(), boneIDs[i], options);
+		if (progress) progress->Step();
+		}, options.propagationThreads);
+	// textures are shared between meshes, so they are loaded serially
+	if (progress) progress->SetStage(Stage_DecodingTextures, numMeshes);
+	for (int i = 0; i < numMeshes; i++)
+	{
+		if (progress && progress->cancelled) return;
+		processedMeshes[i].texIndices = loadMeshTextures(sceneMeshes[i], scene);
+		if (progress) progress->Step();
+	}
+	meshes.reserve(meshes.size() + numMeshes);
+	for (Mesh& m : processedMeshes)
+	{
+		if (!options.deferGPUSetup)
+			m.SetupGPU();
+		meshes.push_back(std::move(m));
+	}
 }
 
-
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+std::vector<int> Model::loadMeshTextures(aiMesh* mesh, const aiScene* scene)
 {
-	std::vector<Vertex> vertices;
 	std::vector<int> texIndices;
-
 	aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
 	std::vector<int> diffuseMaps = texMan.loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", directory);
@@ -131,14 +416,39 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 	texIndices.insert(texIndices.end(), normalMaps.begin(), normalMaps.end());
 	std::vector<int> ambientMaps = texMan.loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_ambient", directory);
 	texIndices.insert(texIndices.end(), ambientMaps.begin(), ambientMaps.end());
+	return texIndices;
+}
+
+std::vector<int> Model::registerMeshBones(aiMesh* mesh)
+{
+	std::vector<int> boneIDs;
+	boneIDs.reserve(mesh->mNumBones);
+	for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+	{
+		aiBone* bone = mesh->mBones[boneIndex];
+		boneIDs.push_back(AddBoneInfo(bone->mName.C_Str(), AssimpGLMHelpers::ConvertMatrixToGLMFormat(bone->mOffsetMatrix)));
+	}
+	return boneIDs;
+}
+
+void Model::SetVertexBoneDataToDefault(Vertex& vertex)
+{
+	vertex.BoneData.NumBones = 0;
+	vertex.BoneData.BoneIDs[0] = -1;
+	vertex.BoneData.Weights[0] = 0.0f;
+}
+
+
+Mesh Model::processMesh(aiMesh* mesh, std::vector<int>&& texIndices, const std::vector<int>& boneIDs, const ModelLoadOptions& options)
+{
+	std::vector<Vertex> vertices;
+	vertices.reserve(mesh->mNumVertices);
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
 		Vertex vertex;
 		SetVertexBoneDataToDefault(vertex);
 		vertex.Position = AssimpGLMHelpers::GetGLMVec(mesh->mVertices[i]);
 		vertex.Normal = AssimpGLMHelpers::GetGLMVec(mesh->mNormals[i]);
-		vertex.associatedWeightMatrix = glm::mat4(1.0f);
-		vertex.originalVertex = NULL;
 
 		if (mesh->mTextureCoords[0])
 		{
@@ -161,9 +471,16 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 		faces.push_back(f);
 	}
 
-	ExtractBoneWeightForVertices(vertices, mesh, scene);
+	ExtractBoneWeightForVertices(vertices, mesh, boneIDs);
 
-	return Mesh(std::move(vertices), std::move(faces), std::move(texIndices));
+	if (!options.verifyPropagation)
+		return Mesh(std::move(vertices), std::move(faces), std::move(texIndices), true, options.propagationThreads);
+	std::vector<Vertex> originalVertices = vertices;
+	Mesh result(std::move(vertices), std::move(faces), std::move(texIndices), true, options.propagationThreads);
+	int mismatches = result.CountPropagationMismatches(std::move(originalVertices));
+	std::cout << "Propagation check of " << mesh->mName.C_Str() << ": " << mismatches << "/" << result.vertices.size()
+		<< " vertices differ from the dense algorithm\n";
+	return result;
 }
 
 void Model::SetVertexBoneData(Vertex& vertex, int boneID, float weight)
@@ -174,28 +491,11 @@ void Model::SetVertexBoneData(Vertex& vertex, int boneID, float weight)
 }
 
 
-void Model::ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene)
+void Model::ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const std::vector<int>& boneIDs)
 {
-	auto& boneInfoMap = m_BoneInfoMap;
-	int& boneCount = m_BoneCounter;
-
 	for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
 	{
-		int boneID = -1;
-		std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
-		if (boneInfoMap.find(boneName) == boneInfoMap.end())
-		{
-			BoneInfo newBoneInfo;
-			newBoneInfo.id = boneCount;
-			newBoneInfo.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
-			boneInfoMap[boneName] = newBoneInfo;
-			boneID = boneCount;
-			boneCount++;
-		}
-		else
-		{
-			boneID = boneInfoMap[boneName].id;
-		}
+		int boneID = boneIDs[boneIndex];
 		assert(boneID != -1);
 		auto weights = mesh->mBones[boneIndex]->mWeights;
 		int numWeights = mesh->mBones[boneIndex]->mNumWeights;
@@ -2,11 +2,15 @@
 
 
 #include "Mesh.h"
+#include "BakedModel.h"
 #include "Shader.h"
 #include "assimp_glm_helpers.h"
 #include "BoneInfo.h"
 #include "Face.h"
 #include "TextureManager.h"
+#include "ModelCache.h"
+#include "ThreadPool.h"
+#include "LoadProgress.h"
 
 #include <string>
 #include <fstream>
@@ -15,6 +19,8 @@
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <random>
 
 //#include <glad/glad.h>
 
@@ -27,6 +33,57 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+// post processing steps applied by assimp, part of the key of the cooked model cache
+constexpr unsigned int MODEL_IMPORT_FLAGS =
+	aiProcess_Triangulate |
+	aiProcess_ImproveCacheLocality |
+	aiProcess_RemoveRedundantMaterials |
+	aiProcess_RemoveComponent |
+	aiProcess_GenUVCoords |
+	aiProcess_SortByPType |
+	aiProcess_FindDegenerates |
+	aiProcess_FindInstances |
+	aiProcess_ValidateDataStructure |
+	aiProcess_OptimizeMeshes |
+	aiProcess_OptimizeGraph |
+	aiProcess_FixInfacingNormals |
+	aiProcess_JoinIdenticalVertices;
+
+// time spent propagating the weights of all the meshes with a number of threads
+struct PropagationTiming {
+	unsigned int numThreads;
+	float time;
+	// vertices whose bones differ from the ones propagated with a single thread
+	int mismatches;
+};
+
+// time spent baking all the meshes with a skinning path
+struct BakeTiming {
+	SkinningPath path;
+	float time;
+	// max difference of the baked positions and normals from the scalar path
+	float maxError;
+};
+
+// time spent baking a model with a number of threads
+struct BakeScalingTiming {
+	unsigned int numThreads;
+	float time;
+};
+
+struct ModelLoadOptions {
+	// use the cooked version of the model when valid and write it otherwise
+	bool useCache = true;
+	// leave the creation of the opengl objects to SetupGPU, so the model can be loaded on any thread.
+	// The texture manager should defer its uploads as well.
+	bool deferGPUSetup = false;
+	// if not null it is updated during the load and checked to cancel it
+	LoadProgress* progress = nullptr;
+	// compare the propagated weights with the ones of the original dense algorithm (slow)
+	bool verifyPropagation = false;
+	// threads importing the meshes and propagating their weights (0 = all of them). The result doesn't depend on it.
+	unsigned int propagationThreads = 0;
+};
 
 class Model
 {
@@ -36,6 +93,17 @@ public:
 	std::string directory;
 	TextureManager& texMan;
 	bool gammaCorrection;
+	// load statistics
+	bool loadedFromCache = false;
+	// time spent loading the model (ms)
+	float loadTime = 0.0f;
+	// time spent by the assimp path (ms), equal to loadTime if the cache was not used
+	float importTime = 0.0f;
+	// time spent by the last Reload (ms)
+	float reloadTime = 0.0f;
+	// time spent by the last UploadDirtyVertices (ms) and the bytes it sent
+	float uploadTime = 0.0f;
+	size_t uploadBytes = 0;
 
 	// default constructor
 	Model() = default;
@@ -43,27 +111,57 @@ public:
 	Model(const Model& m) = default;
 	// move constructor
 	Model(Model&& m) = default;
+	// move constructor binding the model to another texture manager (that must own the same textures)
+	Model(Model&& m, TextureManager& texMan);
 	// constructor, expects a filepath to a 3D model.
-	Model(std::string& path, TextureManager& texMan, bool gamma = false);
+	Model(std::string& path, TextureManager& texMan, const ModelLoadOptions& options = ModelLoadOptions(), bool gamma = false);
 	// bake the model
-	Model Bake(std::vector<glm::mat4>& matrices);
+	// skins the model on the cpu, the vertices are skinned in chunks by numThreads threads (0 = all of them).
+	// The baked model refers to the meshes of this one.
+	BakedModel Bake(std::vector<glm::mat4>& matrices, SkinningPath path = GetBestSkinningPath(), unsigned int numThreads = 0);
+	// skins the model again into a pose baked from it, keeping its arrays and hierarchies
+	void Rebake(BakedModel& baked, std::vector<glm::mat4>& matrices, SkinningPath path = GetBestSkinningPath(), unsigned int numThreads = 0);
+	// bakes the animated meshes into the baked ones, one per animated mesh
+	static void BakeMeshes(std::vector<BakedMesh>& baked, std::vector<Mesh>& animated, std::vector<glm::mat4>& matrices, SkinningPath path, unsigned int numThreads = 0);
+	// bakes a synthetic model with numVertices vertices with 1, 2, 4... threads up to all of them
+	static std::vector<BakeScalingTiming> BenchmarkBakeScaling(int numVertices);
 	// draws the model, and thus all its meshes
 	void Draw(const Shader& shader);
 	std::map<std::string, BoneInfo> GetBoneInfoMap();
 	int AddBoneInfo(std::string&& name, glm::mat4 offset);
 	void Reload();
+	// sends to the gpu only the vertices marked as dirty in the meshes since the last upload
+	void UploadDirtyVertices();
+	// size of the vertex and index buffers of all the meshes
+	size_t GetGPUBytes() const;
+	// creates the opengl objects of the meshes of a model loaded with deferGPUSetup
+	void SetupGPU();
+	// propagates again the weights of the meshes with 1, 2, 4... threads up to all of them
+	std::vector<PropagationTiming> BenchmarkPropagation() const;
+	// bakes the meshes with every skinning path supported by the cpu, without creating opengl objects
+	std::vector<BakeTiming> BenchmarkBake(std::vector<glm::mat4>& matrices);
 private:
 
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
 	int m_BoneCounter = 0;
 
 	// loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-	void loadModel(std::string& path);
-	// processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-	void processNode(aiNode* node, const aiScene* scene);
+	void loadModel(std::string& path, const ModelLoadOptions& options);
+	// builds the meshes from a cooked model, skipping assimp and the weight propagation
+	void loadCookedModel(CookedModel&& cooked, const ModelLoadOptions& options);
+	// collects the data needed to rebuild the model from the cache
+	CookedModel cookModel();
+	// processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+	void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sceneMeshes);
+	// builds the meshes in parallel. Only the opengl objects are created on the calling thread.
+	void processMeshes(const std::vector<aiMesh*>& sceneMeshes, const aiScene* scene, const ModelLoadOptions& options);
+	std::vector<int> loadMeshTextures(aiMesh* mesh, const aiScene* scene);
+	// adds the bones of the mesh to the bone info map and returns the id of each of them
+	std::vector<int> registerMeshBones(aiMesh* mesh);
 
 	void SetVertexBoneDataToDefault(Vertex& vertex);
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+	// thread safe: it only reads the model
+	Mesh processMesh(aiMesh* mesh, std::vector<int>&& texIndices, const std::vector<int>& boneIDs, const ModelLoadOptions& options);
 	void SetVertexBoneData(Vertex& vertex, int boneID, float weight);
-	void ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene);
+	void ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const std::vector<int>& boneIDs);
 };
\ No newline at end of file
@@ -0,0 +1,213 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ModelCache.h"
+
+#include <fstream>
+#include <cstring>
+
+namespace {
+	constexpr char MAGIC[4] = { 'M', 'L', 'C', 'K' };
+
+	struct CacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t importFlags;
+		// guards against a cache written by a build with a different Vertex/Face layout
+		uint32_t vertexSize;
+		uint32_t faceSize;
+		uint32_t numMeshes;
+		uint32_t numBones;
+		int32_t boneCounter;
+		float importTime;
+	};
+
+	struct MeshHeader {
+		uint32_t numVertices;
+		uint32_t numFaces;
+		uint32_t numTextures;
+	};
+
+	// sequential reader over the mapped file, every read is bounds checked
+	class Reader {
+	public:
+		Reader(const unsigned char* data, size_t size) : data(data), size(size) {}
+
+		bool Read(void* dest, size_t bytes)
+		{
+			if (bytes > size - offset) return false;
+			std::memcpy(dest, data + offset, bytes);
+			offset += bytes;
+			return true;
+		}
+
+		bool ReadString(std::string& dest)
+		{
+			uint32_t len = 0;
+			if (!Read(&len, sizeof(len)) || len > size - offset) return false;
+			dest.assign((const char*)(data + offset), len);
+			offset += len;
+			return true;
+		}
+
+	private:
+		const unsigned char* data;
+		size_t size;
+		size_t offset = 0;
+	};
+
+	void WriteString(std::ofstream& out, const std::string& s)
+	{
+		uint32_t len = s.size();
+		out.write((const char*)&len, sizeof(len));
+		out.write(s.data(), len);
+	}
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+		return;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) return;
+	data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data) size = (size_t)fileSize.QuadPart;
+#else
+	fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) return;
+	void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (ptr == MAP_FAILED) return;
+	data = (const unsigned char*)ptr;
+	size = st.st_size;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file) CloseHandle(file);
+#else
+	if (data) munmap((void*)data, size);
+	if (fd >= 0) close(fd);
+#endif
+}
+
+bool MappedFile::IsOpen() const { return data != nullptr; }
+const unsigned char* MappedFile::Data() const { return data; }
+size_t MappedFile::Size() const { return size; }
+
+std::string ModelCache::GetCachePath(const std::string& modelPath)
+{
+	return modelPath + MODEL_CACHE_EXTENSION;
+}
+
+uint64_t ModelCache::HashFile(const std::string& path)
+{
+	MappedFile file(path);
+	if (!file.IsOpen()) return 0;
+	uint64_t hash = 14695981039346656037ull;
+	const unsigned char* data = file.Data();
+	for (size_t i = 0; i < file.Size(); i++) {
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool ModelCache::Read(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, CookedModel& out)
+{
+	MappedFile file(cachePath);
+	if (!file.IsOpen()) return false;
+	Reader reader(file.Data(), file.Size());
+
+	CacheHeader header;
+	if (!reader.Read(&header, sizeof(header))) return false;
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+		|| header.version != MODEL_CACHE_VERSION
+		|| header.sourceHash != sourceHash
+		|| header.importFlags != importFlags
+		|| header.vertexSize != sizeof(Vertex)
+		|| header.faceSize != sizeof(Face))
+		return false;
+
+	CookedModel model;
+	model.boneCounter = header.boneCounter;
+	model.importTime = header.importTime;
+	model.meshes.resize(header.numMeshes);
+	for (CookedMesh& mesh : model.meshes) {
+		MeshHeader meshHeader;
+		if (!reader.Read(&meshHeader, sizeof(meshHeader))) return false;
+		mesh.vertices.resize(meshHeader.numVertices);
+		mesh.faces.resize(meshHeader.numFaces);
+		mesh.textures.resize(meshHeader.numTextures);
+		if (!reader.Read(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex))) return false;
+		if (!reader.Read(mesh.faces.data(), mesh.faces.size() * sizeof(Face))) return false;
+		for (CookedTexture& tex : mesh.textures)
+			if (!reader.ReadString(tex.type) || !reader.ReadString(tex.path)) return false;
+	}
+	for (uint32_t i = 0; i < header.numBones; i++) {
+		std::string name;
+		BoneInfo info;
+		if (!reader.ReadString(name) || !reader.Read(&info.id, sizeof(info.id)) || !reader.Read(&info.offset, sizeof(info.offset)))
+			return false;
+		model.boneInfoMap[std::move(name)] = info;
+	}
+
+	out = std::move(model);
+	return true;
+}
+
+bool ModelCache::Write(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, const CookedModel& model)
+{
+	std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+	if (!out) return false;
+
+	CacheHeader header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = MODEL_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.importFlags = importFlags;
+	header.vertexSize = sizeof(Vertex);
+	header.faceSize = sizeof(Face);
+	header.numMeshes = model.meshes.size();
+	header.numBones = model.boneInfoMap.size();
+	header.boneCounter = model.boneCounter;
+	header.importTime = model.importTime;
+	out.write((const char*)&header, sizeof(header));
+
+	for (const CookedMesh& mesh : model.meshes) {
+		MeshHeader meshHeader{ (uint32_t)mesh.vertices.size(), (uint32_t)mesh.faces.size(), (uint32_t)mesh.textures.size() };
+		out.write((const char*)&meshHeader, sizeof(meshHeader));
+		out.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+		out.write((const char*)mesh.faces.data(), mesh.faces.size() * sizeof(Face));
+		for (const CookedTexture& tex : mesh.textures) {
+			WriteString(out, tex.type);
+			WriteString(out, tex.path);
+		}
+	}
+	for (auto& [name, info] : model.boneInfoMap) {
+		WriteString(out, name);
+		out.write((const char*)&info.id, sizeof(info.id));
+		out.write((const char*)&info.offset, sizeof(info.offset));
+	}
+	return out.good();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Face.h"
+#include "BoneInfo.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+// bump every time the layout of the cooked file or the output of the import pipeline changes
+constexpr uint32_t MODEL_CACHE_VERSION = 2;
+constexpr char MODEL_CACHE_EXTENSION[] = ".mlcache";
+
+struct CookedTexture {
+	std::string type;
+	std::string path;
+};
+
+struct CookedMesh {
+	std::vector<Vertex> vertices;
+	std::vector<Face> faces;
+	std::vector<CookedTexture> textures;
+};
+
+// everything Model needs to rebuild itself without going through assimp and the weight propagation
+struct CookedModel {
+	std::vector<CookedMesh> meshes;
+	std::map<std::string, BoneInfo> boneInfoMap;
+	int boneCounter = 0;
+	// time spent by the assimp path when the cache was written, used to compare the two load paths
+	float importTime = 0.0f;
+};
+
+// read-only view of a whole file mapped in memory
+class MappedFile {
+public:
+	MappedFile(const std::string& path);
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	~MappedFile();
+
+	bool IsOpen() const;
+	const unsigned char* Data() const;
+	size_t Size() const;
+
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+
+namespace ModelCache {
+	// path of the cooked file associated to the given model file
+	std::string GetCachePath(const std::string& modelPath);
+	// 64 bit FNV-1a hash of the content of the file, 0 if the file can't be read
+	uint64_t HashFile(const std::string& path);
+	// reads the cooked model if it exists and it was cooked from the same source with the same import flags
+	bool Read(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, CookedModel& out);
+	// writes the cooked model, returns false if the file can't be written
+	bool Write(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, const CookedModel& model);
+}
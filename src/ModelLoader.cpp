@@ -0,0 +1,130 @@
+#include "ModelLoader.h"
+
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+
+namespace {
+	// every .dae file found next to the model (the directory above the one of the model is used,
+	// so animations stored in sibling folders are found as well)
+	std::vector<std::string> FindAnimations(const std::string& path)
+	{
+		std::vector<std::string> animations;
+		std::string dirName = path.substr(0, path.find_last_of("/"));
+		dirName = dirName.substr(0, dirName.find_last_of("/"));
+		for (auto& animation : std::filesystem::recursive_directory_iterator(dirName)) {
+			if (animation.path().extension().u8string().compare(".dae") != 0)
+				continue;
+			std::string animationPath = animation.path().u8string();
+			std::replace(animationPath.begin(), animationPath.end(), '\\', '/');
+			animations.push_back(animationPath);
+		}
+		return animations;
+	}
+}
+
+ModelLoader::~ModelLoader()
+{
+	Cancel();
+	JoinCancelledWorkers(true);
+}
+
+void ModelLoader::Start(const std::string& path, bool completeLoad, const ModelLoadOptions& options, const KeyframeCompression& compression)
+{
+	Cancel();
+	job = std::make_shared<LoadJob>();
+	job->path = path;
+	std::replace(job->path.begin(), job->path.end(), '\\', '/');
+	job->completeLoad = completeLoad;
+	job->options = options;
+	job->compression = compression;
+	job->options.deferGPUSetup = true;
+	job->options.progress = &job->progress;
+	nextMeshToUpload = 0;
+	worker = std::thread(&ModelLoader::Run, job);
+}
+
+void ModelLoader::Cancel()
+{
+	if (!job)
+		return;
+	job->progress.cancelled = true;
+	if (worker.joinable())
+		cancelledWorkers.emplace_back(job, std::move(worker));
+	job.reset();
+}
+
+bool ModelLoader::IsLoading() const { return job != nullptr; }
+const LoadProgress* ModelLoader::GetProgress() const { return job ? &job->progress : nullptr; }
+const std::string& ModelLoader::GetPath() const { return job->path; }
+
+bool ModelLoader::Update(float budgetMs)
+{
+	JoinCancelledWorkers(false);
+	if (!job || !job->finished)
+		return false;
+	if (worker.joinable())
+		worker.join();
+	if (!job->model || job->model->meshes.empty() || job->animations.empty()) {
+		std::cout << "Failed to load the model at path: " << job->path << "\n";
+		job.reset();
+		return false;
+	}
+
+	// the loading thread is done, create the opengl objects within the time budget
+	auto start = std::chrono::high_resolution_clock::now();
+	Model& model = job->model.value();
+	do {
+		if (job->texMan.UploadPendingTexture()) {
+			job->progress.Step();
+		}
+		else if (nextMeshToUpload < model.meshes.size()) {
+			model.meshes[nextMeshToUpload++].SetupGPU();
+			job->progress.Step();
+		}
+		else {
+			job->progress.stage = Stage_Done;
+			return true;
+		}
+	} while (std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() < budgetMs);
+	return false;
+}
+
+std::shared_ptr<LoadJob> ModelLoader::TakeJob()
+{
+	std::shared_ptr<LoadJob> completed = std::move(job);
+	job.reset();
+	return completed;
+}
+
+void ModelLoader::Run(std::shared_ptr<LoadJob> job)
+{
+	LoadProgress& progress = job->progress;
+	job->texMan.deferUpload = true;
+	job->model.emplace(job->path, job->texMan, job->options);
+
+	if (!progress.cancelled && !job->model->meshes.empty()) {
+		std::vector<std::string> animations = job->completeLoad ? FindAnimations(job->path) : std::vector<std::string>{ job->path };
+		progress.SetStage(Stage_LoadingAnimations, animations.size());
+		for (std::string& animation : animations) {
+			if (progress.cancelled)
+				break;
+			std::cout << animation << "\n";
+			job->animations.emplace_back(animation, job->model.value(), job->compression);
+			progress.Step();
+		}
+		progress.SetStage(Stage_Uploading, job->texMan.pendingTextures.size() + job->model->meshes.size());
+	}
+	job->finished = true;
+}
+
+void ModelLoader::JoinCancelledWorkers(bool wait)
+{
+	auto done = [wait](std::pair<std::shared_ptr<LoadJob>, std::thread>& cancelled) {
+		if (!wait && !cancelled.first->finished)
+			return false;
+		cancelled.second.join();
+		return true;
+	};
+	cancelledWorkers.erase(std::remove_if(cancelledWorkers.begin(), cancelledWorkers.end(), done), cancelledWorkers.end());
+}
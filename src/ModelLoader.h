@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Model.h"
+#include "Animation.h"
+#include "TextureManager.h"
+#include "LoadProgress.h"
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+// max time spent each frame creating the opengl objects of a loaded model (ms)
+constexpr float LOADER_UPLOAD_BUDGET = 8.0f;
+
+// everything produced by a background load. Shared with the loading thread, which may outlive a cancelled load.
+struct LoadJob {
+	std::string path;
+	// load every animation found in the directory of the model, not only the one in the model file
+	bool completeLoad = false;
+	ModelLoadOptions options;
+	KeyframeCompression compression;
+	LoadProgress progress;
+	TextureManager texMan;
+	std::optional<Model> model;
+	std::vector<Animation> animations;
+	std::atomic<bool> finished{ false };
+};
+
+// loads a model and its animations on a background thread (parse -> propagate -> decode textures -> animations),
+// then creates the opengl objects on the main thread a few at a time so the render loop keeps running.
+class ModelLoader {
+public:
+	ModelLoader() = default;
+	ModelLoader(const ModelLoader& other) = delete;
+	ModelLoader& operator=(const ModelLoader& other) = delete;
+	~ModelLoader();
+
+	// starts loading the model, cancelling the load in progress (if any)
+	void Start(const std::string& path, bool completeLoad, const ModelLoadOptions& options, const KeyframeCompression& compression);
+	void Cancel();
+	bool IsLoading() const;
+	const LoadProgress* GetProgress() const;
+	const std::string& GetPath() const;
+	// to call once per frame on the thread owning the opengl context.
+	// Returns true when the model is completely loaded and can be taken with TakeJob.
+	bool Update(float budgetMs = LOADER_UPLOAD_BUDGET);
+	// gives the completed load to the caller
+	std::shared_ptr<LoadJob> TakeJob();
+
+private:
+	std::shared_ptr<LoadJob> job;
+	std::thread worker;
+	// threads of cancelled loads, joined once they notice the cancellation
+	std::vector<std::pair<std::shared_ptr<LoadJob>, std::thread>> cancelledWorkers;
+	size_t nextMeshToUpload = 0;
+
+	static void Run(std::shared_ptr<LoadJob> job);
+	void JoinCancelledWorkers(bool wait);
+};
@@ -0,0 +1,85 @@
+#include "PoseCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+PoseCache::PoseCache(const Animation& animation, size_t budgetBytes, float samplesPerSecond)
+	:
+	m_Animation(animation)
+{
+	for (const AnimationNode& node : m_Animation.GetNodes())
+		m_NumBones = std::max(m_NumBones, node.boneID + 1);
+	if (m_NumBones == 0)
+		return;
+
+	float duration = m_Animation.GetDuration();
+	float ticksPerSecond = m_Animation.GetTicksPerSecond() > 0.0f ? m_Animation.GetTicksPerSecond() : 25.0f;
+	m_FrameTime = ticksPerSecond / samplesPerSecond;
+	m_NumFrames = int(std::ceil(duration / m_FrameTime)) + 1;
+	// lower the rate when the palettes don't fit in the budget
+	int maxFrames = int(budgetBytes / (m_NumBones * sizeof(glm::mat4)));
+	if (m_NumFrames > maxFrames)
+	{
+		m_NumFrames = maxFrames;
+		m_FrameTime = duration / std::max(1, m_NumFrames - 1);
+	}
+	if (m_NumFrames < 2)
+	{
+		m_NumFrames = 0;
+		return;
+	}
+	m_Palettes.resize(size_t(m_NumFrames) * m_NumBones);
+	m_Builder = std::thread(&PoseCache::Build, this);
+}
+
+PoseCache::~PoseCache()
+{
+	m_Cancelled = true;
+	if (m_Builder.joinable())
+		m_Builder.join();
+}
+
+bool PoseCache::Sample(float time, bool blend, std::vector<glm::mat4>& finalBoneMatrices) const
+{
+	if (m_NumFrames == 0)
+		return false;
+	float frame = std::clamp(time / m_FrameTime, 0.0f, float(m_NumFrames - 1));
+	int f0 = std::min(int(frame), m_NumFrames - 2);
+	float factor = frame - f0;
+	int built = m_BuiltFrames.load(std::memory_order_acquire);
+	const glm::mat4* palette0 = &m_Palettes[size_t(f0) * m_NumBones];
+	const glm::mat4* palette1 = palette0 + m_NumBones;
+	if (!blend)
+	{
+		int nearest = factor < 0.5f ? f0 : f0 + 1;
+		if (nearest >= built)
+			return false;
+		std::memcpy(finalBoneMatrices.data(), &m_Palettes[size_t(nearest) * m_NumBones], m_NumBones * sizeof(glm::mat4));
+		return true;
+	}
+	if (f0 + 1 >= built)
+		return false;
+	for (int i = 0; i < m_NumBones; i++)
+		finalBoneMatrices[i] = palette0[i] + (palette1[i] - palette0[i]) * factor;
+	return true;
+}
+
+bool PoseCache::IsReady() const { return m_NumFrames > 0 && m_BuiltFrames == m_NumFrames; }
+float PoseCache::GetProgress() const { return m_NumFrames > 0 ? float(m_BuiltFrames) / m_NumFrames : 0.0f; }
+int PoseCache::GetNumFrames() const { return m_NumFrames; }
+size_t PoseCache::GetMemoryBytes() const { return m_Palettes.size() * sizeof(glm::mat4); }
+
+void PoseCache::Build()
+{
+	size_t numNodes = m_Animation.GetNodes().size();
+	std::vector<glm::mat4> localTransforms(numNodes), globalTransforms(numNodes);
+	std::vector<glm::mat4> finalBoneMatrices(std::max(m_NumBones, MAX_NUM_BONE), glm::mat4(1.0f));
+	std::vector<KeyframeCursor> cursors(m_Animation.GetNumChannels());
+	for (int frame = 0; frame < m_NumFrames && !m_Cancelled; frame++)
+	{
+		m_Animation.CalculatePose(frame * m_FrameTime, cursors, localTransforms, globalTransforms, finalBoneMatrices);
+		std::copy(finalBoneMatrices.begin(), finalBoneMatrices.begin() + m_NumBones, m_Palettes.begin() + size_t(frame) * m_NumBones);
+		m_BuiltFrames.store(frame + 1, std::memory_order_release);
+	}
+}
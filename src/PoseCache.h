@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Animation.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+// default rate of the cached palettes (samples per second)
+constexpr float POSE_CACHE_RATE = 30.0f;
+// default memory allowed to the palettes of a clip, the rate is lowered to fit
+constexpr size_t POSE_CACHE_BUDGET = 64 * 1024 * 1024;
+
+// final bone matrices of a clip precomputed at a fixed rate on a background thread,
+// so scrubbing the timeline copies a palette instead of evaluating the hierarchy
+class PoseCache
+{
+public:
+	PoseCache(const Animation& animation, size_t budgetBytes = POSE_CACHE_BUDGET, float samplesPerSecond = POSE_CACHE_RATE);
+	PoseCache(const PoseCache& other) = delete;
+	PoseCache& operator=(const PoseCache& other) = delete;
+	// stops the building thread
+	~PoseCache();
+
+	// writes the palette at the given time (ticks), blending the two closest frames or taking the nearest one.
+	// Returns false if the needed frames are not built yet.
+	bool Sample(float time, bool blend, std::vector<glm::mat4>& finalBoneMatrices) const;
+
+	bool IsReady() const;
+	float GetProgress() const;
+	int GetNumFrames() const;
+	size_t GetMemoryBytes() const;
+
+private:
+	// copy of the clip used by the building thread
+	Animation m_Animation;
+	int m_NumBones = 0;
+	int m_NumFrames = 0;
+	// ticks between two frames
+	float m_FrameTime = 1.0f;
+	// m_Palettes[frame * m_NumBones + boneID]
+	std::vector<glm::mat4> m_Palettes;
+	std::atomic<int> m_BuiltFrames{ 0 };
+	std::atomic<bool> m_Cancelled{ false };
+	std::thread m_Builder;
+
+	void Build();
+};
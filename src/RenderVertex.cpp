@@ -0,0 +1,68 @@
+#include "RenderVertex.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	float SignNotZero(float x) { return x >= 0.0f ? 1.0f : -1.0f; }
+
+	int16_t ToSnorm16(float x)
+	{
+		return int16_t(std::round(std::clamp(x, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	float FromSnorm16(int16_t x)
+	{
+		return std::max(x / 32767.0f, -1.0f);
+	}
+}
+
+RenderVertex PackVertex(const Vertex& v)
+{
+	RenderVertex r{};
+	r.Position = v.Position;
+	// project the normal on the octahedron |x| + |y| + |z| = 1 and unfold the lower half on the outer triangles
+	glm::vec3 n = v.Normal;
+	float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	glm::vec2 oct = l1 > 0.0f ? glm::vec2(n.x, n.y) / l1 : glm::vec2(0.0f);
+	if (l1 > 0.0f && n.z < 0.0f)
+		oct = glm::vec2((1.0f - std::abs(oct.y)) * SignNotZero(oct.x), (1.0f - std::abs(oct.x)) * SignNotZero(oct.y));
+	r.Normal[0] = ToSnorm16(oct.x);
+	r.Normal[1] = ToSnorm16(oct.y);
+	r.TexCoords[0] = glm::packHalf1x16(v.TexCoords.x);
+	r.TexCoords[1] = glm::packHalf1x16(v.TexCoords.y);
+	int numBones = std::clamp(v.BoneData.NumBones, 0, MAX_BONE_INFLUENCE);
+	for (int i = 0; i < numBones; i++) {
+		r.BoneIDs[i] = uint8_t(v.BoneData.BoneIDs[i]);
+		r.Weights[i] = glm::packHalf1x16(v.BoneData.Weights[i]);
+	}
+	r.NumBones = uint8_t(numBones);
+	return r;
+}
+
+void PackVertices(const std::vector<Vertex>& vertices, std::vector<RenderVertex>& packed)
+{
+	packed.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+		packed[i] = PackVertex(vertices[i]);
+}
+
+void PackShortIndices(const std::vector<Face>& faces, std::vector<uint16_t>& packed)
+{
+	packed.resize(faces.size() * 3);
+	for (size_t i = 0; i < faces.size(); i++)
+		for (int k = 0; k < 3; k++)
+			packed[3 * i + k] = uint16_t(faces[i].indices[k]);
+}
+
+glm::vec3 UnpackNormal(const int16_t normal[2])
+{
+	glm::vec3 n(FromSnorm16(normal[0]), FromSnorm16(normal[1]), 0.0f);
+	n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
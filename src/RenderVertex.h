@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Face.h"
+
+#include <vector>
+#include <cstdint>
+
+// packed copy of a vertex sent to the gpu, only holding what the shaders read (36 bytes instead of sizeof(Vertex))
+struct RenderVertex {
+	glm::vec3 Position;
+	// octahedral encoding of the normal, snorm16
+	int16_t Normal[2];
+	// half floats
+	uint16_t TexCoords[2];
+	// MAX_NUM_BONE fits in a byte
+	uint8_t BoneIDs[MAX_BONE_INFLUENCE];
+	// half floats: edited weights can be negative or greater than one
+	uint16_t Weights[MAX_BONE_INFLUENCE];
+	uint8_t NumBones;
+	uint8_t padding[3];
+};
+
+// largest number of vertices a mesh can have to use 16 bit indices
+constexpr size_t MAX_SHORT_INDEXED_VERTICES = 65536;
+
+RenderVertex PackVertex(const Vertex& v);
+void PackVertices(const std::vector<Vertex>& vertices, std::vector<RenderVertex>& packed);
+// 16 bit indices of the faces, the mesh must have at most MAX_SHORT_INDEXED_VERTICES vertices
+void PackShortIndices(const std::vector<Face>& faces, std::vector<uint16_t>& packed);
+// normal rebuilt from its packed version, as the shaders do
+glm::vec3 UnpackNormal(const int16_t normal[2]);
@@ -0,0 +1,183 @@
+#include "ResampledClip.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLED_CLIP_SSE
+#include <immintrin.h>
+#endif
+
+namespace {
+	// assimp's default when the file doesn't specify it
+	constexpr float DEFAULT_TICKS_PER_SECOND = 25.0f;
+	constexpr int SIMD_WIDTH = 4;
+}
+
+ResampledClip::ResampledClip(const std::vector<Bone>& bones, const std::vector<int>& nodes, float duration, float ticksPerSecond, float samplesPerSecond)
+	:
+	m_NumTracks(bones.size()),
+	m_Stride((bones.size() + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH),
+	m_Nodes(nodes)
+{
+	if (ticksPerSecond <= 0.0f)
+		ticksPerSecond = DEFAULT_TICKS_PER_SECOND;
+	m_FrameTime = ticksPerSecond / samplesPerSecond;
+	// the last frame is at or after the end of the clip, the bones hold their last key there
+	m_NumFrames = std::max(2, int(std::ceil(duration / m_FrameTime)) + 1);
+	m_Data.assign(size_t(m_NumFrames) * NUM_COMPONENTS * m_Stride, 0.0f);
+
+	for (int track = 0; track < m_Stride; track++)
+	{
+		KeyframeCursor cursor;
+		glm::quat previous(1.0f, 0.0f, 0.0f, 0.0f);
+		for (int frame = 0; frame < m_NumFrames; frame++)
+		{
+			glm::vec3 position(0.0f), scale(1.0f);
+			glm::quat rotation = previous;
+			// padding tracks hold the identity
+			if (track < m_NumTracks)
+				bones[track].GetLocalPose(frame * m_FrameTime, cursor, position, rotation, scale);
+			// keep consecutive frames in the same hemisphere, so nlerp takes the short path
+			if (glm::dot(rotation, previous) < 0.0f)
+				rotation = -rotation;
+			previous = rotation;
+			float values[NUM_COMPONENTS] = { position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w, scale.x, scale.y, scale.z };
+			for (int component = 0; component < NUM_COMPONENTS; component++)
+				GetComponent(frame, component)[track] = values[component];
+		}
+	}
+	MeasureError(bones);
+}
+
+void ResampledClip::Sample(float time, std::vector<glm::mat4>& localTransforms) const
+{
+	int f0, f1;
+	float factor;
+	FindFrames(time, f0, f1, factor);
+
+#ifdef RESAMPLED_CLIP_SSE
+	const __m128 t = _mm_set1_ps(factor);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	// columns of the 4 matrices: 3 rows of the rotation * scale columns and the translation
+	alignas(16) float columns[12][SIMD_WIDTH];
+	for (int track = 0; track < m_Stride; track += SIMD_WIDTH)
+	{
+		__m128 values[NUM_COMPONENTS];
+		for (int component = 0; component < NUM_COMPONENTS; component++)
+		{
+			__m128 a = _mm_loadu_ps(GetComponent(f0, component) + track);
+			__m128 b = _mm_loadu_ps(GetComponent(f1, component) + track);
+			values[component] = _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+		}
+		// nlerp
+		__m128 x = values[RX], y = values[RY], z = values[RZ], w = values[RW];
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+		__m128 invLength = _mm_div_ps(one, length);
+		x = _mm_mul_ps(x, invLength);
+		y = _mm_mul_ps(y, invLength);
+		z = _mm_mul_ps(z, invLength);
+		w = _mm_mul_ps(w, invLength);
+
+		__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+		// same layout as glm::toMat4, each column scaled
+		__m128 matrix[12] = {
+			_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), _mm_mul_ps(two, _mm_add_ps(xy, wz)), _mm_mul_ps(two, _mm_sub_ps(xz, wy)),
+			_mm_mul_ps(two, _mm_sub_ps(xy, wz)), _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), _mm_mul_ps(two, _mm_add_ps(yz, wx)),
+			_mm_mul_ps(two, _mm_add_ps(xz, wy)), _mm_mul_ps(two, _mm_sub_ps(yz, wx)), _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))),
+			values[PX], values[PY], values[PZ]
+		};
+		for (int row = 0; row < 3; row++)
+		{
+			_mm_store_ps(columns[row], _mm_mul_ps(matrix[row], values[SX]));
+			_mm_store_ps(columns[3 + row], _mm_mul_ps(matrix[3 + row], values[SY]));
+			_mm_store_ps(columns[6 + row], _mm_mul_ps(matrix[6 + row], values[SZ]));
+			_mm_store_ps(columns[9 + row], matrix[9 + row]);
+		}
+
+		int count = std::min(SIMD_WIDTH, m_NumTracks - track);
+		for (int i = 0; i < count; i++)
+		{
+			glm::mat4& local = localTransforms[m_Nodes[track + i]];
+			for (int column = 0; column < 4; column++)
+				local[column] = glm::vec4(columns[column * 3][i], columns[column * 3 + 1][i], columns[column * 3 + 2][i], column == 3 ? 1.0f : 0.0f);
+		}
+	}
+#else
+	for (int track = 0; track < m_NumTracks; track++)
+	{
+		glm::vec3 position, scale;
+		glm::quat rotation;
+		SampleTrack(track, time, position, rotation, scale);
+		localTransforms[m_Nodes[track]] = glm::translate(glm::mat4(1.0f), position) * glm::toMat4(rotation) * glm::scale(glm::mat4(1.0f), scale);
+	}
+#endif
+}
+
+int ResampledClip::GetNumTracks() const { return m_NumTracks; }
+int ResampledClip::GetNumFrames() const { return m_NumFrames; }
+size_t ResampledClip::GetMemoryBytes() const { return m_Data.size() * sizeof(float) + m_Nodes.size() * sizeof(int); }
+
+const float* ResampledClip::GetComponent(int frame, int component) const
+{
+	return m_Data.data() + (size_t(frame) * NUM_COMPONENTS + component) * m_Stride;
+}
+
+float* ResampledClip::GetComponent(int frame, int component)
+{
+	return m_Data.data() + (size_t(frame) * NUM_COMPONENTS + component) * m_Stride;
+}
+
+void ResampledClip::FindFrames(float time, int& frame0, int& frame1, float& factor) const
+{
+	float frame = std::clamp(time / m_FrameTime, 0.0f, float(m_NumFrames - 1));
+	frame0 = std::min(int(frame), m_NumFrames - 2);
+	frame1 = frame0 + 1;
+	factor = frame - frame0;
+}
+
+void ResampledClip::SampleTrack(int track, float time, glm::vec3& position, glm::quat& rotation, glm::vec3& scale) const
+{
+	int f0, f1;
+	float factor;
+	FindFrames(time, f0, f1, factor);
+	float values[NUM_COMPONENTS];
+	for (int component = 0; component < NUM_COMPONENTS; component++)
+	{
+		float a = GetComponent(f0, component)[track];
+		float b = GetComponent(f1, component)[track];
+		values[component] = a + factor * (b - a);
+	}
+	position = glm::vec3(values[PX], values[PY], values[PZ]);
+	rotation = glm::normalize(glm::quat(values[RW], values[RX], values[RY], values[RZ]));
+	scale = glm::vec3(values[SX], values[SY], values[SZ]);
+}
+
+void ResampledClip::MeasureError(const std::vector<Bone>& bones)
+{
+	maxPositionError = maxRotationError = maxScaleError = 0.0f;
+	for (int track = 0; track < m_NumTracks; track++)
+	{
+		const Bone& bone = bones[track];
+		// the original tracks are linear between the keys, so the error is largest at the keys
+		auto measure = [&](float time) {
+			KeyframeCursor cursor;
+			glm::vec3 position, scale, sampledPosition, sampledScale;
+			glm::quat rotation, sampledRotation;
+			bone.GetLocalPose(time, cursor, position, rotation, scale);
+			SampleTrack(track, time, sampledPosition, sampledRotation, sampledScale);
+			maxPositionError = std::max(maxPositionError, glm::length(position - sampledPosition));
+			maxRotationError = std::max(maxRotationError, GetAngleDegrees(rotation, sampledRotation));
+			maxScaleError = std::max(maxScaleError, glm::length(scale - sampledScale));
+		};
+		for (const KeyPosition& key : bone.GetPositions())
+			measure(key.timeStamp);
+		for (int key = 0; key < bone.GetNumRotationKeys(); key++)
+			measure(bone.GetRotationTime(key));
+		for (const KeyScale& key : bone.GetScales())
+			measure(key.timeStamp);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Bone.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// default sampling rate of the resampled tracks (samples per second)
+constexpr float RESAMPLE_RATE = 60.0f;
+
+// all the channels of a clip sampled at a fixed rate, stored as structure of arrays:
+// for every frame each component (position x, y, z, rotation x, y, z, w, scale x, y, z)
+// is contiguous across the channels, so a frame is sampled with one index computation
+// and the interpolation runs on 4 channels at once.
+class ResampledClip
+{
+public:
+	// track i samples bones[i] and is written to the transform of nodes[i]
+	ResampledClip(const std::vector<Bone>& bones, const std::vector<int>& nodes, float duration, float ticksPerSecond, float samplesPerSecond = RESAMPLE_RATE);
+
+	// writes the local transformation of every animated node at the given time (ticks)
+	void Sample(float time, std::vector<glm::mat4>& localTransforms) const;
+
+	int GetNumTracks() const;
+	int GetNumFrames() const;
+	size_t GetMemoryBytes() const;
+
+	// max error at the original keys
+	float maxPositionError = 0.0f;
+	// degrees
+	float maxRotationError = 0.0f;
+	float maxScaleError = 0.0f;
+
+private:
+	enum Component { PX, PY, PZ, RX, RY, RZ, RW, SX, SY, SZ, NUM_COMPONENTS };
+
+	int m_NumTracks;
+	// number of tracks rounded up to a multiple of 4
+	int m_Stride;
+	int m_NumFrames;
+	// ticks between two frames
+	float m_FrameTime;
+	std::vector<int> m_Nodes;
+	// m_Data[(frame * NUM_COMPONENTS + component) * m_Stride + track]
+	std::vector<float> m_Data;
+
+	const float* GetComponent(int frame, int component) const;
+	float* GetComponent(int frame, int component);
+	// frames around the time and interpolation factor between them
+	void FindFrames(float time, int& frame0, int& frame1, float& factor) const;
+	// one track without simd, used to measure the error and when sse is not available
+	void SampleTrack(int track, float time, glm::vec3& position, glm::quat& rotation, glm::vec3& scale) const;
+	void MeasureError(const std::vector<Bone>& bones);
+};
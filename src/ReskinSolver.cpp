@@ -0,0 +1,81 @@
+#include "ReskinSolver.h"
+
+#include <cfloat>
+#include <algorithm>
+
+#include <Eigen/Dense>
+
+namespace {
+	// slightly negative weights of the optimum left by the rounding are clamped instead of discarding it
+	constexpr float NEGATIVE_WEIGHT_TOLERANCE = 1e-5f;
+
+	using Columns = Eigen::Matrix<float, 3, Eigen::Dynamic, 0, 3, MAX_BONE_INFLUENCE>;
+	using Solution = Eigen::Matrix<float, Eigen::Dynamic, 1, 0, MAX_BONE_INFLUENCE, 1>;
+}
+
+float SolveSkinningWeights(const glm::vec3 (&candidates)[MAX_BONE_INFLUENCE], int numCandidates, glm::vec3 target, const ReskinOptions& options, float (&weights)[MAX_BONE_INFLUENCE])
+{
+	std::fill(weights, weights + MAX_BONE_INFLUENCE, 0.0f);
+	// without the sum, no bones at all is a valid solution
+	float bestResidual = options.sumToOne ? FLT_MAX : glm::length(target);
+	int allBones = (1 << numCandidates) - 1;
+	// the non-negative optimum is the unconstrained optimum of the bones with a positive weight, so it's found among
+	// the optima of every subset of the bones. All of them are solved first: if that one is feasible it's the optimum.
+	int lastSubset = options.nonNegative ? 1 : allBones;
+	for (int subset = allBones; subset >= lastSubset; subset--) {
+		int bones[MAX_BONE_INFLUENCE];
+		int numBones = 0;
+		for (int k = 0; k < numCandidates; k++)
+			if (subset & (1 << k))
+				bones[numBones++] = k;
+
+		// with the sum the last bone takes the weight left by the others, leaving them unconstrained
+		int numFree = options.sumToOne ? numBones - 1 : numBones;
+		glm::vec3 origin = options.sumToOne ? candidates[bones[numBones - 1]] : glm::vec3(0.0f);
+		Columns columns(3, numFree);
+		for (int j = 0; j < numFree; j++) {
+			glm::vec3 column = candidates[bones[j]] - origin;
+			columns.col(j) = Eigen::Vector3f(column.x, column.y, column.z);
+		}
+		glm::vec3 rhs = target - origin;
+		Solution solution(numFree);
+		if (numFree > 0)
+			solution = columns.colPivHouseholderQr().solve(Eigen::Vector3f(rhs.x, rhs.y, rhs.z));
+
+		float subsetWeights[MAX_BONE_INFLUENCE] = {};
+		float sum = 0.0f;
+		for (int j = 0; j < numFree; j++) {
+			subsetWeights[bones[j]] = solution(j);
+			sum += solution(j);
+		}
+		if (options.sumToOne)
+			subsetWeights[bones[numBones - 1]] = 1.0f - sum;
+		if (options.nonNegative) {
+			bool feasible = true;
+			sum = 0.0f;
+			for (int j = 0; j < numBones; j++) {
+				float& w = subsetWeights[bones[j]];
+				feasible = feasible && w >= -NEGATIVE_WEIGHT_TOLERANCE;
+				w = std::max(w, 0.0f);
+				sum += w;
+			}
+			if (!feasible)
+				continue;
+			if (options.sumToOne)
+				for (int j = 0; j < numBones; j++)
+					subsetWeights[bones[j]] /= sum;
+		}
+
+		glm::vec3 blended(0.0f);
+		for (int k = 0; k < numCandidates; k++)
+			blended += subsetWeights[k] * candidates[k];
+		float residual = glm::length(blended - target);
+		if (residual < bestResidual) {
+			bestResidual = residual;
+			std::copy(subsetWeights, subsetWeights + MAX_BONE_INFLUENCE, weights);
+		}
+		if (subset == allBones)
+			break;
+	}
+	return bestResidual;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "VertexBoneData.h"
+
+#include <glm/glm.hpp>
+
+struct ReskinOptions {
+	// weights can't be negative
+	bool nonNegative = true;
+	// weights of a vertex add up to one
+	bool sumToOne = true;
+};
+
+// least squares weights of the candidate bones of a vertex, given the position each of them alone would skin it to,
+// so that the blend reaches target. Fixed-size types only, safe to call from any thread.
+// The constraints are exact: every face of the feasible set is solved and the closest feasible solution is kept.
+// Returns the distance between the blended position and target.
+float SolveSkinningWeights(const glm::vec3 (&candidates)[MAX_BONE_INFLUENCE], int numCandidates, glm::vec3 target, const ReskinOptions& options, float (&weights)[MAX_BONE_INFLUENCE]);
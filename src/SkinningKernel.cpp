@@ -0,0 +1,347 @@
+#include "SkinningKernel.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SKINNING_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// msvc compiles avx2 intrinsics without /arch:AVX2, they just must not run on older cpus
+#define SKINNING_AVX2
+#define SKINNING_AVX2_TARGET
+#elif defined(__GNUC__)
+#define SKINNING_AVX2
+#define SKINNING_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+void SkinningInput::Load(const std::vector<Vertex>& vertices, int begin, int end)
+{
+	int n = end - begin;
+	px.resize(n); py.resize(n); pz.resize(n);
+	nx.resize(n); ny.resize(n); nz.resize(n);
+	boneIDs.assign(n * MAX_BONE_INFLUENCE, 0);
+	weights.assign(n * MAX_BONE_INFLUENCE, 0.0f);
+	for (int i = 0; i < n; i++) {
+		const Vertex& v = vertices[begin + i];
+		px[i] = v.Position.x; py[i] = v.Position.y; pz[i] = v.Position.z;
+		nx[i] = v.Normal.x; ny[i] = v.Normal.y; nz[i] = v.Normal.z;
+		for (int k = 0; k < v.BoneData.NumBones && k < MAX_BONE_INFLUENCE; k++) {
+			boneIDs[i * MAX_BONE_INFLUENCE + k] = v.BoneData.BoneIDs[k];
+			weights[i * MAX_BONE_INFLUENCE + k] = v.BoneData.Weights[k];
+		}
+	}
+}
+
+void SkinningOutput::Resize(int numVertices)
+{
+	px.resize(numVertices); py.resize(numVertices); pz.resize(numVertices);
+	nx.resize(numVertices); ny.resize(numVertices); nz.resize(numVertices);
+}
+
+namespace {
+	// reference implementation, one vertex at a time with glm
+	void SkinScalar(const SkinningInput& in, const std::vector<glm::mat4>& matrices, SkinningOutput& out, glm::mat4* blendedMatrices, int begin, int end)
+	{
+		for (int i = begin; i < end; i++) {
+			glm::mat4 cumulativeMatrix = glm::mat4(0.0f);
+			for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+				cumulativeMatrix += in.weights[i * MAX_BONE_INFLUENCE + k] * matrices[in.boneIDs[i * MAX_BONE_INFLUENCE + k]];
+			glm::vec3 position = glm::vec3(cumulativeMatrix * glm::vec4(in.px[i], in.py[i], in.pz[i], 1.0f));
+			glm::vec3 normal = glm::normalize(glm::vec3(cumulativeMatrix * glm::vec4(in.nx[i], in.ny[i], in.nz[i], 0.0f)));
+			out.px[i] = position.x; out.py[i] = position.y; out.pz[i] = position.z;
+			out.nx[i] = normal.x; out.ny[i] = normal.y; out.nz[i] = normal.z;
+			blendedMatrices[i] = cumulativeMatrix;
+		}
+	}
+
+#ifdef SKINNING_SSE
+	// 4 vertices per iteration: the matrices are blended one vertex at a time (a column per register),
+	// transposed and applied to the position and normal streams of the 4 vertices together
+	void SkinSSE(const SkinningInput& in, const std::vector<glm::mat4>& matrices, SkinningOutput& out, glm::mat4* blendedMatrices, int begin, int end)
+	{
+		constexpr int WIDTH = 4;
+		int i = begin;
+		for (; i + WIDTH <= end; i += WIDTH) {
+			// m[row][column], once transposed each register holds an element for the 4 vertices
+			__m128 m[4][4];
+			for (int v = 0; v < WIDTH; v++) {
+				const int* ids = &in.boneIDs[(i + v) * MAX_BONE_INFLUENCE];
+				const float* w = &in.weights[(i + v) * MAX_BONE_INFLUENCE];
+				__m128 columns[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+				for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+					__m128 weight = _mm_set1_ps(w[k]);
+					const float* bone = &matrices[ids[k]][0][0];
+					for (int c = 0; c < 4; c++)
+						columns[c] = _mm_add_ps(columns[c], _mm_mul_ps(weight, _mm_loadu_ps(bone + 4 * c)));
+				}
+				float* blended = &blendedMatrices[i + v][0][0];
+				for (int c = 0; c < 4; c++) {
+					_mm_storeu_ps(blended + 4 * c, columns[c]);
+					m[v][c] = columns[c];
+				}
+			}
+			for (int c = 0; c < 4; c++)
+				_MM_TRANSPOSE4_PS(m[0][c], m[1][c], m[2][c], m[3][c]);
+
+			__m128 x = _mm_loadu_ps(&in.px[i]), y = _mm_loadu_ps(&in.py[i]), z = _mm_loadu_ps(&in.pz[i]);
+			for (int r = 0; r < 3; r++) {
+				__m128 p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[r][0], x), _mm_mul_ps(m[r][1], y)), _mm_add_ps(_mm_mul_ps(m[r][2], z), m[r][3]));
+				float* dst = r == 0 ? &out.px[i] : r == 1 ? &out.py[i] : &out.pz[i];
+				_mm_storeu_ps(dst, p);
+			}
+
+			x = _mm_loadu_ps(&in.nx[i]), y = _mm_loadu_ps(&in.ny[i]), z = _mm_loadu_ps(&in.nz[i]);
+			__m128 n[3];
+			for (int r = 0; r < 3; r++)
+				n[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[r][0], x), _mm_mul_ps(m[r][1], y)), _mm_mul_ps(m[r][2], z));
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(n[0], n[0]), _mm_mul_ps(n[1], n[1])), _mm_mul_ps(n[2], n[2])));
+			_mm_storeu_ps(&out.nx[i], _mm_div_ps(n[0], length));
+			_mm_storeu_ps(&out.ny[i], _mm_div_ps(n[1], length));
+			_mm_storeu_ps(&out.nz[i], _mm_div_ps(n[2], length));
+		}
+		SkinScalar(in, matrices, out, blendedMatrices, i, end);
+	}
+#endif
+
+#ifdef SKINNING_AVX2
+	// 8 vertices per iteration: the matrices are blended two columns per register, then the elements
+	// of the 8 blended matrices are gathered to transform the streams
+	SKINNING_AVX2_TARGET void SkinAVX2(const SkinningInput& in, const std::vector<glm::mat4>& matrices, SkinningOutput& out, glm::mat4* blendedMatrices, int begin, int end)
+	{
+		constexpr int WIDTH = 8;
+		const __m256i matrixOffsets = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+		int i = begin;
+		for (; i + WIDTH <= end; i += WIDTH) {
+			for (int v = 0; v < WIDTH; v++) {
+				const int* ids = &in.boneIDs[(i + v) * MAX_BONE_INFLUENCE];
+				const float* w = &in.weights[(i + v) * MAX_BONE_INFLUENCE];
+				__m256 low = _mm256_setzero_ps(), high = _mm256_setzero_ps();
+				for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+					__m256 weight = _mm256_set1_ps(w[k]);
+					const float* bone = &matrices[ids[k]][0][0];
+					low = _mm256_fmadd_ps(weight, _mm256_loadu_ps(bone), low);
+					high = _mm256_fmadd_ps(weight, _mm256_loadu_ps(bone + 8), high);
+				}
+				float* blended = &blendedMatrices[i + v][0][0];
+				_mm256_storeu_ps(blended, low);
+				_mm256_storeu_ps(blended + 8, high);
+			}
+			// m[row][column] of the 8 matrices, the last row is not needed
+			const float* blended = &blendedMatrices[i][0][0];
+			__m256 m[3][4];
+			for (int c = 0; c < 4; c++)
+				for (int r = 0; r < 3; r++)
+					m[r][c] = _mm256_i32gather_ps(blended + 4 * c + r, matrixOffsets, 4);
+
+			__m256 x = _mm256_loadu_ps(&in.px[i]), y = _mm256_loadu_ps(&in.py[i]), z = _mm256_loadu_ps(&in.pz[i]);
+			for (int r = 0; r < 3; r++) {
+				__m256 p = _mm256_fmadd_ps(m[r][0], x, _mm256_fmadd_ps(m[r][1], y, _mm256_fmadd_ps(m[r][2], z, m[r][3])));
+				float* dst = r == 0 ? &out.px[i] : r == 1 ? &out.py[i] : &out.pz[i];
+				_mm256_storeu_ps(dst, p);
+			}
+
+			x = _mm256_loadu_ps(&in.nx[i]), y = _mm256_loadu_ps(&in.ny[i]), z = _mm256_loadu_ps(&in.nz[i]);
+			__m256 n[3];
+			for (int r = 0; r < 3; r++)
+				n[r] = _mm256_fmadd_ps(m[r][0], x, _mm256_fmadd_ps(m[r][1], y, _mm256_mul_ps(m[r][2], z)));
+			__m256 length = _mm256_sqrt_ps(_mm256_fmadd_ps(n[0], n[0], _mm256_fmadd_ps(n[1], n[1], _mm256_mul_ps(n[2], n[2]))));
+			_mm256_storeu_ps(&out.nx[i], _mm256_div_ps(n[0], length));
+			_mm256_storeu_ps(&out.ny[i], _mm256_div_ps(n[1], length));
+			_mm256_storeu_ps(&out.nz[i], _mm256_div_ps(n[2], length));
+		}
+		SkinScalar(in, matrices, out, blendedMatrices, i, end);
+	}
+#endif
+
+	void InvertScalar(const glm::mat4* matrices, glm::mat3* inverses, int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			inverses[i] = glm::inverse(glm::mat3(matrices[i]));
+	}
+
+	// writes the inverse of matrix v of a batch, given as elements [column * 3 + row][v]
+	template<int WIDTH>
+	void StoreInverse(const float (&elements)[9][WIDTH], int v, glm::mat3& inverse)
+	{
+		for (int c = 0; c < 3; c++)
+			for (int r = 0; r < 3; r++)
+				inverse[c][r] = elements[c * 3 + r][v];
+	}
+
+#ifdef SKINNING_SSE
+	// determinant of the 2x2 block of columns c0, c1 and rows r0, r1
+	inline __m128 Cofactor(const __m128 (&m)[3][3], int c0, int r0, int c1, int r1)
+	{
+		return _mm_sub_ps(_mm_mul_ps(m[c0][r0], m[c1][r1]), _mm_mul_ps(m[c1][r0], m[c0][r1]));
+	}
+
+	// 4 matrices per iteration, each register holds an element of the 4 matrices. Inverse through the cofactors, as glm.
+	void InvertSSE(const glm::mat4* matrices, glm::mat3* inverses, int begin, int end)
+	{
+		constexpr int WIDTH = 4;
+		int i = begin;
+		for (; i + WIDTH <= end; i += WIDTH) {
+			const float* p = &matrices[i][0][0];
+			__m128 m[3][3];
+			for (int c = 0; c < 3; c++)
+				for (int r = 0; r < 3; r++) {
+					int k = c * 4 + r;
+					m[c][r] = _mm_set_ps(p[48 + k], p[32 + k], p[16 + k], p[k]);
+				}
+			// inverse[c][r] = cofactor of element (column r, row c) / det
+			__m128 inv[9] = {
+				Cofactor(m, 1, 1, 2, 2), _mm_sub_ps(_mm_setzero_ps(), Cofactor(m, 0, 1, 2, 2)), Cofactor(m, 0, 1, 1, 2),
+				_mm_sub_ps(_mm_setzero_ps(), Cofactor(m, 1, 0, 2, 2)), Cofactor(m, 0, 0, 2, 2), _mm_sub_ps(_mm_setzero_ps(), Cofactor(m, 0, 0, 1, 2)),
+				Cofactor(m, 1, 0, 2, 1), _mm_sub_ps(_mm_setzero_ps(), Cofactor(m, 0, 0, 2, 1)), Cofactor(m, 0, 0, 1, 1)
+			};
+			__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], inv[0]), _mm_mul_ps(m[1][0], inv[1])), _mm_mul_ps(m[2][0], inv[2]));
+			__m128 oneOverDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+			alignas(16) float elements[9][WIDTH];
+			for (int e = 0; e < 9; e++)
+				_mm_store_ps(elements[e], _mm_mul_ps(inv[e], oneOverDet));
+			for (int v = 0; v < WIDTH; v++)
+				StoreInverse(elements, v, inverses[i + v]);
+		}
+		InvertScalar(matrices, inverses, i, end);
+	}
+#endif
+
+#ifdef SKINNING_AVX2
+	SKINNING_AVX2_TARGET inline __m256 Cofactor(const __m256 (&m)[3][3], int c0, int r0, int c1, int r1)
+	{
+		return _mm256_fmsub_ps(m[c0][r0], m[c1][r1], _mm256_mul_ps(m[c1][r0], m[c0][r1]));
+	}
+
+	// 8 matrices per iteration, the elements are gathered across the matrices
+	SKINNING_AVX2_TARGET void InvertAVX2(const glm::mat4* matrices, glm::mat3* inverses, int begin, int end)
+	{
+		constexpr int WIDTH = 8;
+		const __m256i stride = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+		int i = begin;
+		for (; i + WIDTH <= end; i += WIDTH) {
+			const float* p = &matrices[i][0][0];
+			__m256 m[3][3];
+			for (int c = 0; c < 3; c++)
+				for (int r = 0; r < 3; r++)
+					m[c][r] = _mm256_i32gather_ps(p + c * 4 + r, stride, 4);
+			__m256 zero = _mm256_setzero_ps();
+			__m256 inv[9] = {
+				Cofactor(m, 1, 1, 2, 2), _mm256_sub_ps(zero, Cofactor(m, 0, 1, 2, 2)), Cofactor(m, 0, 1, 1, 2),
+				_mm256_sub_ps(zero, Cofactor(m, 1, 0, 2, 2)), Cofactor(m, 0, 0, 2, 2), _mm256_sub_ps(zero, Cofactor(m, 0, 0, 1, 2)),
+				Cofactor(m, 1, 0, 2, 1), _mm256_sub_ps(zero, Cofactor(m, 0, 0, 2, 1)), Cofactor(m, 0, 0, 1, 1)
+			};
+			__m256 det = _mm256_fmadd_ps(m[2][0], inv[2], _mm256_fmadd_ps(m[1][0], inv[1], _mm256_mul_ps(m[0][0], inv[0])));
+			__m256 oneOverDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+			alignas(32) float elements[9][WIDTH];
+			for (int e = 0; e < 9; e++)
+				_mm256_store_ps(elements[e], _mm256_mul_ps(inv[e], oneOverDet));
+			for (int v = 0; v < WIDTH; v++)
+				StoreInverse(elements, v, inverses[i + v]);
+		}
+		InvertScalar(matrices, inverses, i, end);
+	}
+#endif
+
+#ifdef SKINNING_AVX2
+	bool CpuSupportsAVX2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool fma = info[2] & (1 << 12);
+		bool osxsave = info[2] & (1 << 27);
+		bool avx = info[2] & (1 << 28);
+		// the os must save the ymm registers
+		if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return info[1] & (1 << 5);
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+#endif
+}
+
+void SkinVertices(const SkinningInput& input, const std::vector<glm::mat4>& matrices, SkinningOutput& output, glm::mat4* blendedMatrices, int begin, int end, SkinningPath path)
+{
+	if (!IsSkinningPathSupported(path))
+		path = Skinning_Scalar;
+	switch (path) {
+#ifdef SKINNING_AVX2
+	case Skinning_AVX2:
+		SkinAVX2(input, matrices, output, blendedMatrices, begin, end);
+		break;
+#endif
+#ifdef SKINNING_SSE
+	case Skinning_SSE:
+		SkinSSE(input, matrices, output, blendedMatrices, begin, end);
+		break;
+#endif
+	default:
+		SkinScalar(input, matrices, output, blendedMatrices, begin, end);
+	}
+}
+
+void InvertBlendedMatrices(const glm::mat4* blendedMatrices, glm::mat3* inverses, int count, SkinningPath path)
+{
+	if (!IsSkinningPathSupported(path))
+		path = Skinning_Scalar;
+	switch (path) {
+#ifdef SKINNING_AVX2
+	case Skinning_AVX2:
+		InvertAVX2(blendedMatrices, inverses, 0, count);
+		break;
+#endif
+#ifdef SKINNING_SSE
+	case Skinning_SSE:
+		InvertSSE(blendedMatrices, inverses, 0, count);
+		break;
+#endif
+	default:
+		InvertScalar(blendedMatrices, inverses, 0, count);
+	}
+}
+
+bool IsSkinningPathSupported(SkinningPath path)
+{
+	switch (path) {
+	case Skinning_Scalar:
+		return true;
+#ifdef SKINNING_SSE
+	case Skinning_SSE:
+		return true;
+#endif
+#ifdef SKINNING_AVX2
+	case Skinning_AVX2:
+	{
+		static const bool supported = CpuSupportsAVX2();
+		return supported;
+	}
+#endif
+	default:
+		return false;
+	}
+}
+
+SkinningPath GetBestSkinningPath()
+{
+	static const SkinningPath best = IsSkinningPathSupported(Skinning_AVX2) ? Skinning_AVX2
+		: IsSkinningPathSupported(Skinning_SSE) ? Skinning_SSE : Skinning_Scalar;
+	return best;
+}
+
+const char* GetSkinningPathName(SkinningPath path)
+{
+	switch (path) {
+	case Skinning_SSE: return "SSE";
+	case Skinning_AVX2: return "AVX2";
+	default: return "Scalar";
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+enum SkinningPath
+{
+	Skinning_Scalar,
+	Skinning_SSE,
+	Skinning_AVX2,
+	Skinning_NumPaths
+};
+
+// vertices to skin, stored as separate streams so several vertices are loaded at once
+struct SkinningInput {
+	std::vector<float> px, py, pz;
+	std::vector<float> nx, ny, nz;
+	// MAX_BONE_INFLUENCE per vertex, unused influences have bone 0 and weight 0
+	std::vector<int> boneIDs;
+	std::vector<float> weights;
+
+	// loads the vertices [begin, end) at the start of the streams
+	void Load(const std::vector<Vertex>& vertices, int begin, int end);
+	int Size() const { return int(px.size()); }
+};
+
+struct SkinningOutput {
+	std::vector<float> px, py, pz;
+	std::vector<float> nx, ny, nz;
+
+	void Resize(int numVertices);
+};
+
+// linear blend skinning of the vertices [begin, end) of the input, written at the same positions of the output
+// and of blendedMatrices (the matrix of each vertex). The output must already have the size of the input.
+// Falls back to the scalar path if the given one is not supported.
+void SkinVertices(const SkinningInput& input, const std::vector<glm::mat4>& matrices, SkinningOutput& output, glm::mat4* blendedMatrices, int begin, int end, SkinningPath path);
+// inverses of the 3x3 linear parts of the blended matrices [0, count). The offsets of the edits are directions, so the
+// linear part is all that is needed to bring them back to the bind pose. Singular matrices give non finite inverses, as glm.
+// Falls back to the scalar path if the given one is not supported.
+void InvertBlendedMatrices(const glm::mat4* blendedMatrices, glm::mat3* inverses, int count, SkinningPath path);
+// fastest path supported by the cpu, detected once
+SkinningPath GetBestSkinningPath();
+bool IsSkinningPathSupported(SkinningPath path);
+const char* GetSkinningPathName(SkinningPath path);
@@ -1,5 +1,9 @@
 #include "StatusManager.h"
 
+#include <chrono>
+#include <random>
+#include <iostream>
+
 StatusManager::StatusManager(float screenWidth, float screenHeight)
 	:
 	mouseLastPos(glm::vec2(screenWidth / 2, screenHeight / 2)),
@@ -24,7 +28,8 @@ StatusManager::StatusManager(float screenWidth, float screenHeight)
 	selectedShader(Shader("./Shaders/selected.vs", "./Shaders/selected.fs")),
 	numBonesShader(Shader("./Shaders/num_bones_visualization.vs", "./Shaders/num_bones_visualization.fs")),
 	currentBoneShader(Shader("./Shaders/influence_of_single_bone.vs", "./Shaders/influence_of_single_bone.fs")),
-	currentChange(Change(selectedVerticesPointers)),
+	pickingShader(Shader("./Shaders/picking.vs", "./Shaders/picking.fs")),
+	currentChange(Change()),
 	changeIndex(-1)
 {
 	// setup selected vertices vao
@@ -47,15 +52,19 @@ StatusManager::StatusManager(float screenWidth, float screenHeight)
 void StatusManager::AddAnimation(const char* path)
 {
 	assert(animatedModel);
-	animator.AddAnimation(Animation(std::string(path), *animatedModel));
+	animator.AddAnimation(Animation(std::string(path), *animatedModel, animationCompression));
 }
 
 void StatusManager::Pause()
 {
 	pause = !pause;
-	if (pause)
-		BakeModel();
-	else
+	if (pause) {
+		if (!bakedModel)
+			BakeModel();
+		else // the pose kept while playing, refitted hierarchies get slower as the pose moves away from the built one
+			bakedModel->BuildBVHs();
+	}
+	else if (!pickWhilePlaying)
 		UnbakeModel();
 }
 
@@ -63,9 +72,9 @@ void StatusManager::SetPivot()
 {
 	assert(bakedModel.has_value());
 	if (info.hitPoint) {
-		Mesh& hittedMesh = bakedModel->meshes[info.meshIndex];
+		BakedMesh& hittedMesh = bakedModel->meshes[info.meshIndex];
 		int closestIndex = getClosestVertexIndex(info.hitPoint.value(), hittedMesh, info.face.value());
-		camera.pivot = hittedMesh.vertices[closestIndex].Position;
+		camera.pivot = hittedMesh.positions[closestIndex];
 		info = PickingInfo{};
 	}
 	else {
@@ -86,6 +95,10 @@ void StatusManager::Update()
 	if (pause)
 		return;
 	animator.UpdateAnimation(deltaTime);
+	if (pickWhilePlaying)
+		UpdatePlaybackPicking();
+	else if (bakedModel)
+		UnbakeModel();
 }
 
 void StatusManager::NextAnimation()
@@ -101,6 +114,21 @@ void StatusManager::PrevAnimation()
 void StatusManager::BakeModel() {
 	assert(!bakedModel.has_value());
 	bakedModel.emplace(animatedModel->Bake(animator.GetFinalBoneMatrices()));
+	bakedModel->BuildBVHs();
+}
+
+void StatusManager::UpdatePlaybackPicking()
+{
+	if (!bakedModel)
+		BakeModel();
+	else {
+		animatedModel->Rebake(*bakedModel, animator.GetFinalBoneMatrices());
+		if (!useGPUPicking)
+			bakedModel->RefitBVHs();
+	}
+	// the model moves under the mouse even if it stays still
+	if (!useGPUPicking)
+		info = Picking();
 }
 
 void StatusManager::UnbakeModel()
@@ -114,6 +142,9 @@ void StatusManager::UnbakeModel()
 PickingInfo StatusManager::Picking()
 {
 	assert(bakedModel.has_value());
+	// the gpu pass updates the picking info every frame
+	if (useGPUPicking)
+		return info;
 	glm::vec2 mousePos = (mouseLastPos / glm::vec2(width, height)) * 2.0f - 1.0f;
 	mousePos.y = -mousePos.y; //origin is top-left and +y mouse is down
 
@@ -130,19 +161,41 @@ PickingInfo StatusManager::Picking()
 
 	glm::vec3 dir = glm::normalize(glm::vec3(rayEndPos - rayStartPos));
 
+	auto start = std::chrono::high_resolution_clock::now();
+	lastPickTrianglesTested = 0;
+	PickingInfo res = PickRay(rayStartPos, dir, usePickingBVH, lastPickTrianglesTested);
+	lastPickTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return res;
+}
+
+PickingInfo StatusManager::PickRay(glm::vec3 origin, glm::vec3 dir, bool useBVH, int& trianglesTested)
+{
 	float minDist = 0.0f;
 
 	PickingInfo res{};
 	for (int i = 0; i < bakedModel->meshes.size(); i++)
 	{
-		Mesh& m = bakedModel->meshes[i];
+		BakedMesh& m = bakedModel->meshes[i];
 		if (!animatedModel->meshes[i].enabled) continue;
-		for (Face& f : m.faces)
+		if (useBVH)
 		{
-			Vertex& ver1 = m.vertices[f.indices[0]];
-			Vertex& ver2 = m.vertices[f.indices[1]];
-			Vertex& ver3 = m.vertices[f.indices[2]];
-			IntersectionInfo tmpInfo = rayTriangleIntersection(rayStartPos, dir, ver1, ver2, ver3);
+			BVHHit hit = m.bvh.Intersect(origin, dir, trianglesTested);
+			if (hit.face >= 0 && (!res.face || hit.distance < minDist))
+			{
+				res.hitPoint = hit.point;
+				res.face.emplace(m.GetFaces()[hit.face]);
+				res.meshIndex = i;
+				res.distance = minDist = hit.distance;
+			}
+			continue;
+		}
+		for (const Face& f : m.GetFaces())
+		{
+			glm::vec3& ver1 = m.positions[f.indices[0]];
+			glm::vec3& ver2 = m.positions[f.indices[1]];
+			glm::vec3& ver3 = m.positions[f.indices[2]];
+			IntersectionInfo tmpInfo = rayTriangleIntersection(origin, dir, ver1, ver2, ver3);
+			trianglesTested++;
 			if (tmpInfo.distance > FLT_EPSILON)
 			{
 				//object i has been clicked. probably best to find the minimum t1 (front-most object)
@@ -160,35 +213,71 @@ PickingInfo StatusManager::Picking()
 	return res;
 }
 
+PickingBenchmarkResult StatusManager::BenchmarkPicking(int numRays)
+{
+	assert(bakedModel.has_value());
+	PickingBenchmarkResult result;
+	// rays aimed at the centers of random triangles, so that most of them hit the model
+	std::vector<std::pair<int, int>> targets;
+	for (int i = 0; i < bakedModel->meshes.size(); i++)
+		if (animatedModel->meshes[i].enabled && !bakedModel->meshes[i].GetFaces().empty())
+			targets.emplace_back(i, int(bakedModel->meshes[i].GetFaces().size()));
+	if (targets.empty())
+		return result;
+	std::mt19937 generator(42);
+	std::vector<glm::vec3> directions(numRays);
+	for (glm::vec3& dir : directions) {
+		auto [meshIndex, numFaces] = targets[std::uniform_int_distribution<int>(0, targets.size() - 1)(generator)];
+		BakedMesh& m = bakedModel->meshes[meshIndex];
+		const Face& f = m.GetFaces()[std::uniform_int_distribution<int>(0, numFaces - 1)(generator)];
+		glm::vec3 center = (m.positions[f.indices[0]] + m.positions[f.indices[1]] + m.positions[f.indices[2]]) / 3.0f;
+		dir = glm::normalize(center - camera.position);
+	}
+
+	std::vector<PickingInfo> bvhPicks(numRays);
+	int bvhTested = 0, bruteForceTested = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < numRays; r++)
+		bvhPicks[r] = PickRay(camera.position, directions[r], true, bvhTested);
+	result.bvhTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / numRays;
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < numRays; r++) {
+		PickingInfo pick = PickRay(camera.position, directions[r], false, bruteForceTested);
+		if (pick.meshIndex != bvhPicks[r].meshIndex || pick.face.has_value() != bvhPicks[r].face.has_value()
+			|| (pick.face && pick.face->indices != bvhPicks[r].face->indices))
+			result.mismatches++;
+	}
+	result.bruteForceTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / numRays;
+	result.numRays = numRays;
+	result.bvhTrianglesTested = float(bvhTested) / numRays;
+	result.bruteForceTrianglesTested = float(bruteForceTested) / numRays;
+	std::cout << "Picking " << numRays << " rays: BVH " << result.bvhTime << " ms and " << result.bvhTrianglesTested
+		<< " triangles per pick, brute force " << result.bruteForceTime << " ms and " << result.bruteForceTrianglesTested
+		<< " triangles per pick, " << result.mismatches << " mismatches\n";
+	return result;
+}
+
 void StatusManager::DrawSelectedVertices()
 {
 	if (selectedVertices.size() == 0) return;
 	assert(bakedModel.has_value());
+	// the baked positions are already skinned
+	std::vector<glm::vec3> positions;
+	positions.reserve(selectedVertices.size());
+	for (SelectedVertex& v : selectedVertices)
+		positions.push_back(bakedModel->meshes[v.meshIndex].positions[v.vertexIndex]);
 	glBindVertexArray(SVAO);
 	// load data into vertex buffers
 	glBindBuffer(GL_ARRAY_BUFFER, SVBO);
-	glBufferData(GL_ARRAY_BUFFER, selectedVertices.size() * sizeof(Vertex), &selectedVertices[0], GL_STREAM_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STREAM_DRAW);
 	// position
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-	// bone ids
-	glEnableVertexAttribArray(1);
-	glVertexAttribIPointer(1, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, BoneData.BoneIDs[0]));
-	// weights
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, BoneData.Weights[0]));
-	// num bones
-	glEnableVertexAttribArray(3);
-	glVertexAttribIPointer(3, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, BoneData.NumBones));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
 	selectedShader.use();
 	// model/view/projection transformations
 	glm::mat4 modelView = camera.viewMatrix;
 	selectedShader.setMat4("modelView", modelView);
 	selectedShader.setMat4("projection", projection);
-	// pass bones matrices to the shader
-	auto transforms = animator.GetFinalBoneMatrices();
-	for (int i = 0; i < transforms.size(); ++i)
-		selectedShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	glEnable(GL_POLYGON_OFFSET_FILL);
@@ -205,9 +294,9 @@ void StatusManager::Undo()
 	if (changeIndex >= 0) {
 		assert(changeIndex < changes.size());
 		changes[changeIndex--].Undo();
-		animatedModel.value().Reload();
+		animatedModel.value().UploadDirtyVertices();
+		UpdatePickingBVHs();
 	}
-	UpdateSelectedVertices();
 }
 
 void StatusManager::Redo()
@@ -216,9 +305,9 @@ void StatusManager::Redo()
 		assert(changes.size() > 0);
 		assert(changeIndex >= -1);
 		changes[++changeIndex].Apply();
-		animatedModel.value().Reload();
+		animatedModel.value().UploadDirtyVertices();
+		UpdatePickingBVHs();
 	}
-	UpdateSelectedVertices();
 }
 
 bool StatusManager::IsChanging()
@@ -230,39 +319,46 @@ bool StatusManager::IsChanging()
 
 void StatusManager::LoadModel(std::string& path)
 {
-	animator.animations.clear();
-	animator.currentAnimationIndex = 0;
-	texMan.ClearTextures();
-	animatedModel.emplace(path, texMan);
-	if (pause)
-		BakeModel();
-	else
-		UnbakeModel();
-	AddAnimation(path.c_str());
+	loader.Start(path, false, GetLoadOptions(), animationCompression);
 }
 
 void StatusManager::CompleteLoad(std::string& path)
 {
-	animator.animations.clear();
-	animator.currentAnimationIndex = 0;
+	loader.Start(path, true, GetLoadOptions(), animationCompression);
+}
+
+ModelLoadOptions StatusManager::GetLoadOptions() const
+{
+	ModelLoadOptions options;
+	// a cooked model is already propagated, there would be nothing to check
+	options.useCache = useModelCache && !verifyPropagation;
+	options.verifyPropagation = verifyPropagation;
+	options.propagationThreads = propagationThreads;
+	return options;
+}
+
+void StatusManager::UpdateLoading()
+{
+	if (loader.Update())
+		SwapLoadedModel();
+}
+
+void StatusManager::SwapLoadedModel()
+{
+	std::shared_ptr<LoadJob> job = loader.TakeJob();
+	// everything pointing to the old model has to go
+	UnbakeModel();
+	changes.clear();
+	changeIndex = -1;
+	currentChange = Change();
+	info = PickingInfo{};
+
 	texMan.ClearTextures();
-	animatedModel.emplace(path, texMan);
+	texMan.textures = std::move(job->texMan.textures);
+	animatedModel.emplace(std::move(job->model.value()), texMan);
+	animator.SetAnimations(std::move(job->animations));
 	if (pause)
 		BakeModel();
-	else
-		UnbakeModel();
-	std::string dir_name = path.substr(0, path.find_last_of("/"));
-	dir_name = dir_name.substr(0, dir_name.find_last_of("/"));
-	auto dir = std::filesystem::recursive_directory_iterator(dir_name);
-	for (auto animation : dir) {
-		if (animation.path().extension().u8string().compare(".dae") != 0)
-			continue;
-		dir_name = animation.path().u8string();
-		std::replace(dir_name.begin(), dir_name.end(), '\\', '/');
-		std::cout << dir_name << "\n";
-		AddAnimation(dir_name.c_str());
-	}
-	
 }
 
 bool StatusManager::SelectHoveredVertex()
@@ -270,117 +366,44 @@ bool StatusManager::SelectHoveredVertex()
 	assert(info.hitPoint.has_value());
 	assert(bakedModel.has_value());
 
-	Mesh& bMesh = bakedModel.value().meshes[info.meshIndex];
+	BakedMesh& bMesh = bakedModel.value().meshes[info.meshIndex];
 	Face& f = info.face.value();
 	int verIndex = getClosestVertexIndex(info.hitPoint.value(), bMesh, f);
-	Vertex* v = &bMesh.vertices[verIndex];
-	if (bMesh.vertices[verIndex].originalVertex->BoneData.NumBones < 4) return false;
-	//avoid duplicates and allow removing selected vertices
-	auto iter = std::find(selectedVertices.begin(), selectedVertices.end(), *v);
-	int index = iter - selectedVertices.begin();
-	if (iter == selectedVertices.end()) {
-		selectedVertices.push_back(*v);
-		selectedVerticesPointers.push_back(v);
-	}
-	else if (removeIfDouble) {
-		selectedVertices.erase(iter);
-		selectedVerticesPointers.erase(selectedVerticesPointers.begin() + index);
-	}
-	return true;
+	return SelectVertex(info.meshIndex, verIndex);
 }
 
 bool StatusManager::SelectHoveredEdge()
 {
-	Mesh& bMesh = bakedModel.value().meshes[info.meshIndex];
+	BakedMesh& bMesh = bakedModel.value().meshes[info.meshIndex];
 	Face& f = info.face.value();
 	Line closestLine = getClosestLineIndex(info.hitPoint.value(), bMesh, f);
-	Vertex* v1 = &bMesh.vertices[closestLine.v1];
-	Vertex* v2 = &bMesh.vertices[closestLine.v2];
-	bool selected = false;
-	if (bMesh.vertices[f.indices[0]].originalVertex->BoneData.NumBones == 4) {
-		//avoid duplicates and allow removing selected vertices
-		auto iter = std::find(selectedVertices.begin(), selectedVertices.end(), *v1);
-		int index = iter - selectedVertices.begin();
-		if (iter == selectedVertices.end()) {
-			selectedVertices.push_back(*v1);
-			selectedVerticesPointers.push_back(v1);
-		}
-		else if (removeIfDouble) {
-			selectedVertices.erase(iter);
-			selectedVerticesPointers.erase(selectedVerticesPointers.begin() + index);
-		}
-		selected = true;
-	}
-	if (bMesh.vertices[f.indices[1]].originalVertex->BoneData.NumBones == 4) {
-		//avoid duplicates and allow removing selected vertices
-		auto iter = std::find(selectedVertices.begin(), selectedVertices.end(), *v2);
-		int index = iter - selectedVertices.begin();
-		if (iter == selectedVertices.end()) {
-			selectedVertices.push_back(*v2);
-			selectedVerticesPointers.push_back(v2);
-		}
-		else if (removeIfDouble) {
-			selectedVertices.erase(iter);
-			selectedVerticesPointers.erase(selectedVerticesPointers.begin() + index);
-		}
-		selected = true;
-	}
+	bool selected = SelectVertex(info.meshIndex, closestLine.v1);
+	selected = SelectVertex(info.meshIndex, closestLine.v2) || selected;
 	return selected;
 }
 
 bool StatusManager::SelectHoveredFace()
 {
-	Mesh& bMesh = bakedModel.value().meshes[info.meshIndex];
 	Face& f = info.face.value();
-	Vertex* v1 = &bMesh.vertices[f.indices[0]];
-	Vertex* v2 = &bMesh.vertices[f.indices[1]];
-	Vertex* v3 = &bMesh.vertices[f.indices[2]];
 	bool selected = false;
-	if (bMesh.vertices[f.indices[0]].originalVertex->BoneData.NumBones == 4) {
-		//avoid duplicates and allow removing selected vertices
-		auto iter = std::find(selectedVertices.begin(), selectedVertices.end(), *v1);
-		int index = iter - selectedVertices.begin();
-		if (iter == selectedVertices.end()) {
-			selectedVertices.push_back(*v1);
-			selectedVerticesPointers.push_back(v1);
-		}
-		else if (removeIfDouble) {
-			selectedVertices.erase(iter);
-			selectedVerticesPointers.erase(selectedVerticesPointers.begin() + index);
-		}
-		selected = true;
-	}
-	if (bMesh.vertices[f.indices[1]].originalVertex->BoneData.NumBones == 4) {
-		//avoid duplicates and allow removing selected vertices
-		auto iter = std::find(selectedVertices.begin(), selectedVertices.end(), *v2);
-		int index = iter - selectedVertices.begin();
-		if (iter == selectedVertices.end()) {
-			selectedVertices.push_back(*v2);
-			selectedVerticesPointers.push_back(v2);
-		}
-		else if (removeIfDouble) {
-			selectedVertices.erase(iter);
-			selectedVerticesPointers.erase(selectedVerticesPointers.begin() + index);
-		}
-		selected = true;
-	}
-	if (bMesh.vertices[f.indices[2]].originalVertex->BoneData.NumBones == 4) {
-		//avoid duplicates and allow removing selected vertices
-		auto iter = std::find(selectedVertices.begin(), selectedVertices.end(), *v3);
-		int index = iter - selectedVertices.begin();
-		if (iter == selectedVertices.end()) {
-			selectedVertices.push_back(*v3);
-			selectedVerticesPointers.push_back(v3);
-		}
-		else if (removeIfDouble) {
-			selectedVertices.erase(iter);
-			selectedVerticesPointers.erase(selectedVerticesPointers.begin() + index);
-		}
-		selected = true;
-	}
+	for (unsigned int index : f.indices)
+		selected = SelectVertex(info.meshIndex, index) || selected;
 	return selected;
 }
 
+bool StatusManager::SelectVertex(int meshIndex, int vertexIndex)
+{
+	if (bakedModel.value().meshes[meshIndex].GetOriginalVertex(vertexIndex).BoneData.NumBones < MAX_BONE_INFLUENCE) return false;
+	//avoid duplicates and allow removing selected vertices
+	SelectedVertex v{ meshIndex, vertexIndex };
+	auto iter = std::find(selectedVertices.begin(), selectedVertices.end(), v);
+	if (iter == selectedVertices.end())
+		selectedVertices.push_back(v);
+	else if (removeIfDouble)
+		selectedVertices.erase(iter);
+	return true;
+}
+
 void StatusManager::StartChange()
 {
 	startChangingPos = info.hitPoint.value();
@@ -392,7 +415,7 @@ void StatusManager::StartChange()
 		changes.pop_back();
 	}
 
-	currentChange = Change(selectedVerticesPointers);
+	currentChange = Change(GetSelectedChangedVertices());
 	info = PickingInfo{};
 }
 
@@ -400,6 +423,14 @@ void StatusManager::EndChange()
 {
 	changes.push_back(currentChange);
 	changeIndex++;
+	UpdatePickingBVHs();
+}
+
+void StatusManager::UpdatePickingBVHs()
+{
+	// the edited vertices moved the baked triangles
+	if (bakedModel)
+		bakedModel->BuildBVHs();
 }
 
 void StatusManager::TweakSelectedVertices()
@@ -426,8 +457,7 @@ void StatusManager::TweakSelectedVertices()
 	hotPoint = glm::vec3(rayStartPos) + dir * rayLenghtOnChangeStart;
 	glm::vec3 offset = hotPoint - startChangingPos;
 	currentChange.Modify(offset);
-	animatedModel.value().Reload();
-	UpdateSelectedVertices();
+	animatedModel.value().UploadDirtyVertices();
 }
 
 void StatusManager::IncreaseCurrentBoneID()
@@ -447,6 +477,7 @@ void StatusManager::Render()
 	//TODO REVIEW
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	UpdateLoading();
 	if (!animatedModel)
 		return;
 	Update();
@@ -471,6 +502,10 @@ void StatusManager::Render()
 		DrawModel(numBonesShader);
 	}
 
+	// the ids are rendered with the same pose, the hovered face is ready before drawing it
+	if (useGPUPicking && bakedModel)
+		UpdateGPUPicking();
+
 	// render selected vertices
 	DrawSelectedVertices();
 	if (!info.hitPoint)
@@ -511,31 +546,54 @@ void StatusManager::DrawModel(Shader& modelShader) {
 	else if (visualMode == Mode_CurrentBoneIDInfluence)
 		modelShader.setInt("currentBoneID", currentBoneID);
 
-	// pass bones matrices to the shader
-	auto transforms = animator.GetFinalBoneMatrices();
-	for (int i = 0; i < transforms.size(); ++i)
-		modelShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+	SetBoneMatrices(modelShader);
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	glEnable(GL_POLYGON_OFFSET_FILL);
 	glPolygonOffset(1.0, 1.0);
-	/*if (pause)
-		bakedModel.value().Draw(modelShader);
-	else*/
 	animatedModel.value().Draw(modelShader);
 }
 
+void StatusManager::SetBoneMatrices(Shader& shader)
+{
+	// pass bones matrices to the shader
+	auto& transforms = animator.GetFinalBoneMatrices();
+	for (int i = 0; i < transforms.size(); ++i)
+		shader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+}
+
+void StatusManager::UpdateGPUPicking()
+{
+	pickingShader.use();
+	pickingShader.setMat4("modelView", camera.viewMatrix);
+	pickingShader.setMat4("projection", projection);
+	SetBoneMatrices(pickingShader);
+	gpuPicker.Render(animatedModel->meshes, pickingShader, int(width), int(height), mouseLastPos, projection * camera.viewMatrix);
+	std::optional<GPUPickResult> result = gpuPicker.Poll();
+	if (!result)
+		return;
+	info = PickingInfo{};
+	// the readback could come from a model that has been replaced since
+	if (result->meshIndex < 0 || result->meshIndex >= animatedModel->meshes.size()
+		|| result->face >= animatedModel->meshes[result->meshIndex].faces.size())
+		return;
+	info.hitPoint = result->hitPoint;
+	info.face.emplace(animatedModel->meshes[result->meshIndex].faces[result->face]);
+	info.meshIndex = result->meshIndex;
+	info.distance = result->distance;
+}
+
 void StatusManager::DrawHoveredFace() {
 	assert(bakedModel.has_value());
 	assert(info.hitPoint.has_value());
-	Mesh& m = bakedModel.value().meshes[info.meshIndex];
+	BakedMesh& m = bakedModel.value().meshes[info.meshIndex];
 	Face& f = info.face.value();
 
 	//vertex
 	float hoveredVertices[9] = {
-		m.vertices[f.indices[0]].Position.x, m.vertices[f.indices[0]].Position.y, m.vertices[f.indices[0]].Position.z,
-		m.vertices[f.indices[1]].Position.x, m.vertices[f.indices[1]].Position.y, m.vertices[f.indices[1]].Position.z,
-		m.vertices[f.indices[2]].Position.x, m.vertices[f.indices[2]].Position.y, m.vertices[f.indices[2]].Position.z,
+		m.positions[f.indices[0]].x, m.positions[f.indices[0]].y, m.positions[f.indices[0]].z,
+		m.positions[f.indices[1]].x, m.positions[f.indices[1]].y, m.positions[f.indices[1]].z,
+		m.positions[f.indices[2]].x, m.positions[f.indices[2]].y, m.positions[f.indices[2]].z,
 	};
 	hoverShader.use();
 	glBindVertexArray(HVAO);
@@ -560,12 +618,12 @@ void StatusManager::DrawHoveredFace() {
 void StatusManager::DrawHoveredPoint() {
 	assert(bakedModel.has_value());
 	assert(info.hitPoint.has_value());
-	Mesh& m = bakedModel.value().meshes[info.meshIndex];
+	BakedMesh& m = bakedModel.value().meshes[info.meshIndex];
 	Face& f = info.face.value();
 	int index = getClosestVertexIndex(info.hitPoint.value(), m, f);
 
 	//vertex
-	float hoveredVertices[3] = { m.vertices[index].Position.x, m.vertices[index].Position.y, m.vertices[index].Position.z };
+	float hoveredVertices[3] = { m.positions[index].x, m.positions[index].y, m.positions[index].z };
 
 	hoverShader.use();
 	glBindVertexArray(HVAO);
@@ -613,26 +671,29 @@ void StatusManager::DrawHotPoint()
 	glBindVertexArray(0);
 }
 
-void StatusManager::UpdateSelectedVertices()
+std::vector<ChangedVertex> StatusManager::GetSelectedChangedVertices()
 {
-	selectedVertices.clear();
-	for (Vertex* v : selectedVerticesPointers)
-		selectedVertices.push_back(*v);
+	assert(bakedModel.has_value());
+	std::vector<ChangedVertex> changed;
+	changed.reserve(selectedVertices.size());
+	for (SelectedVertex& v : selectedVertices) {
+		BakedMesh& m = bakedModel->meshes[v.meshIndex];
+		changed.push_back(ChangedVertex{ &m.positions[v.vertexIndex], &m.GetOriginalVertex(v.vertexIndex), m.mesh, v.vertexIndex, m.inverseWeightMatrices[v.vertexIndex] });
+	}
+	return changed;
 }
 
-
-
 void StatusManager::DrawHoveredLine() {
 	assert(bakedModel.has_value());
 	assert(info.hitPoint.has_value());
-	Mesh& m = bakedModel.value().meshes[info.meshIndex];
+	BakedMesh& m = bakedModel.value().meshes[info.meshIndex];
 	Face& f = info.face.value();
 	auto line = getClosestLineIndex(info.hitPoint.value(), m, f);
 
 	//vertex
 	float hoveredVertices[6] = {
-		m.vertices[line.v1].Position.x, m.vertices[line.v1].Position.y, m.vertices[line.v1].Position.z,
-		m.vertices[line.v2].Position.x, m.vertices[line.v2].Position.y, m.vertices[line.v2].Position.z
+		m.positions[line.v1].x, m.positions[line.v1].y, m.positions[line.v1].z,
+		m.positions[line.v2].x, m.positions[line.v2].y, m.positions[line.v2].z
 	};
 
 	hoverShader.use();
@@ -6,6 +6,9 @@
 #include "Utility.h"
 #include "Shader.h"
 #include "Change.h"
+#include "ModelLoader.h"
+#include "GPUPicker.h"
+#include "InputQueue.h"
 
 #include <optional>
 #include <utility>
@@ -16,6 +19,29 @@
 #include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
 
+// vertex of the baked model
+struct SelectedVertex {
+	int meshIndex;
+	int vertexIndex;
+
+	friend bool operator==(const SelectedVertex& v1, const SelectedVertex& v2)
+	{
+		return v1.meshIndex == v2.meshIndex && v1.vertexIndex == v2.vertexIndex;
+	}
+};
+
+struct PickingBenchmarkResult {
+	int numRays = 0;
+	// average time per pick (ms)
+	float bvhTime = 0.0f;
+	float bruteForceTime = 0.0f;
+	// average ray-triangle tests per pick
+	float bvhTrianglesTested = 0.0f;
+	float bruteForceTrianglesTested = 0.0f;
+	// picks where the two methods found a different triangle
+	int mismatches = 0;
+};
+
 enum SelectionMode
 {
 	Mode_Vertex,
@@ -44,20 +70,41 @@ public:
 	Camera camera;
 	Animator animator;
 	TextureManager texMan;
-	std::optional<Model> animatedModel, bakedModel;
+	ModelLoader loader;
+	std::optional<Model> animatedModel;
+	std::optional<BakedModel> bakedModel;
 	float lastFrame;
 	float deltaTime;
 	//status of the render
 	bool pause;
 	bool wireframeEnabled;
+	//load models through the cooked cache instead of assimp when possible
+	bool useModelCache = true;
+	//check the weight propagation against the original algorithm while loading (slow, skips the cache)
+	bool verifyPropagation = false;
+	//threads propagating the weights of the loaded models (0 = all of them)
+	int propagationThreads = 0;
+	//compression of the keyframes of the animations imported from now on
+	KeyframeCompression animationCompression{ true };
 	//info about the window
 	float width = 800.0f;
 	float height = 800.0f;
 	glm::mat4 projection = glm::mat4(1.0f);
+	//input received by the callbacks, handled once per frame
+	InputQueue inputQueue;
 	//additional info
-	std::vector<Vertex> selectedVertices;
-	std::vector<Vertex*> selectedVerticesPointers;
+	std::vector<SelectedVertex> selectedVertices;
 	PickingInfo info;
+	//pick through the hierarchies of the baked meshes instead of testing every triangle
+	bool usePickingBVH = true;
+	//keep the baked pose while playing, skinned again and with refitted hierarchies every frame, to hover and select
+	bool pickWhilePlaying = false;
+	//pick by reading back the triangle ids rendered on the gpu instead of casting rays on the cpu
+	bool useGPUPicking = false;
+	GPUPicker gpuPicker;
+	//stats of the last pick
+	int lastPickTrianglesTested = 0;
+	float lastPickTime = 0.0f;
 	//variables for tweaking
 	Change currentChange;
 	std::vector<Change> changes;
@@ -80,6 +127,7 @@ public:
 	Shader selectedShader;
 	Shader numBonesShader;
 	Shader currentBoneShader;
+	Shader pickingShader;
 	int currentBoneID = -1;
 	int selectionMode = 0;
 	bool removeIfDouble = false;
@@ -89,7 +137,9 @@ public:
 
 	//loading functions
 	void AddAnimation(const char* path);
+	// models are loaded in background, the current model is replaced once the new one is ready
 	void LoadModel(std::string& path);
+	// like LoadModel, but loads all the animations found in the directory of the model as well
 	void CompleteLoad(std::string& path);
 
 	//animation management
@@ -101,6 +151,8 @@ public:
 
 	//utilities
 	PickingInfo Picking();
+	// casts numRays rays from the camera to random triangles of the baked model, with and without the hierarchies
+	PickingBenchmarkResult BenchmarkPicking(int numRays);
 	void SetPivot();
 	bool SelectHoveredVertex();
 	bool SelectHoveredEdge();
@@ -129,9 +181,25 @@ private:
 	void DrawHoveredLine();
 	void DrawHoveredPoint();
 	void DrawHotPoint();
+	void SetBoneMatrices(Shader& shader);
+	// renders the ids of the triangles and updates the picking info with the readbacks that are ready
+	void UpdateGPUPicking();
+
+	//loading
+	void UpdateLoading();
+	void SwapLoadedModel();
+	ModelLoadOptions GetLoadOptions() const;
 
 	//utilities
-	void UpdateSelectedVertices();
+	// adds the vertex of the baked model to the selection (or removes it). Returns false if it can't be selected.
+	bool SelectVertex(int meshIndex, int vertexIndex);
+	// selected vertices with the editing data of their baked mesh
+	std::vector<ChangedVertex> GetSelectedChangedVertices();
+	// closest triangle of the enabled baked meshes hit by the ray
+	PickingInfo PickRay(glm::vec3 origin, glm::vec3 dir, bool useBVH, int& trianglesTested);
 	void BakeModel();
 	void UnbakeModel();
+	void UpdatePickingBVHs();
+	// bakes the current frame into the pose kept while playing and picks again under the mouse
+	void UpdatePlaybackPicking();
 };
\ No newline at end of file
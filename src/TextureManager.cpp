@@ -42,26 +42,13 @@ int TextureManager::LoadTextureFromFile(const char* path, std::string type)
 
 	int width, height, nrComponents;
 	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-	if (data)
+	if (data && deferUpload)
 	{
-		glGenTextures(1, &textureID);
-		GLenum format{};
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
+		pendingTextures.push_back(PendingTexture{ (int)textures.size(), std::shared_ptr<unsigned char>(data, stbi_image_free), width, height, nrComponents });
+	}
+	else if (data)
+	{
+		textureID = UploadTexture(data, width, height, nrComponents);
 		stbi_image_free(data);
 	}
 	else
@@ -70,11 +57,44 @@ int TextureManager::LoadTextureFromFile(const char* path, std::string type)
 		stbi_image_free(data);
 	}
 
-	Texture tex{ textureID, path, type };
+	Texture tex{ textureID, type, path };
 	textures.emplace_back(tex);
 	return textures.size() - 1;
 }
 
+bool TextureManager::UploadPendingTexture()
+{
+	if (pendingTextures.empty())
+		return false;
+	PendingTexture& pending = pendingTextures.back();
+	textures[pending.index].id = UploadTexture(pending.data.get(), pending.width, pending.height, pending.nrComponents);
+	pendingTextures.pop_back();
+	return true;
+}
+
+unsigned int TextureManager::UploadTexture(unsigned char* data, int width, int height, int nrComponents)
+{
+	unsigned int textureID{};
+	glGenTextures(1, &textureID);
+	GLenum format{};
+	if (nrComponents == 1)
+		format = GL_RED;
+	else if (nrComponents == 3)
+		format = GL_RGB;
+	else if (nrComponents == 4)
+		format = GL_RGBA;
+
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return textureID;
+}
+
 void TextureManager::BindTextures(std::vector<int>& texIndices, const Shader& shader)
 {
 	unsigned int diffuseNr = 1;
@@ -112,4 +132,5 @@ void TextureManager::FlipTextures(bool flip)
 void TextureManager::ClearTextures()
 {
 	textures.clear();
+	pendingTextures.clear();
 }
@@ -6,10 +6,25 @@
 #include <stb/stb_image.h>
 #include <assimp/scene.h>
 #include <vector>
+#include <memory>
+
+// texture decoded while the upload was deferred, waiting to be sent to the gpu
+struct PendingTexture {
+	int index;
+	std::shared_ptr<unsigned char> data;
+	int width;
+	int height;
+	int nrComponents;
+};
 
 class TextureManager {
 public:
 	std::vector<Texture> textures;
+	// if set, textures are only decoded and UploadPendingTexture creates the opengl objects later.
+	// This allows loading textures from threads not owning the opengl context.
+	bool deferUpload = false;
+	std::vector<PendingTexture> pendingTextures;
+
 	TextureManager();
 	// checks all material textures of a given type and loads the textures if they're not loaded yet.
 	// the required infos are returned as a vector of indices to use the textures of the texture manager
@@ -17,9 +32,14 @@ public:
 	std::vector<int> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const char* typeName, std::string& directory);
 	// loads the texture from a file and return the index in textures of the texture loaded 
 	int LoadTextureFromFile(const char* filename, std::string type = "");
+	// uploads the next texture decoded while deferUpload was set. Returns false if there was none.
+	bool UploadPendingTexture();
 	// bind the corrisponding textures to the given shader
 	void BindTextures(std::vector<int>& texIndices, const Shader& shader);
 	// change the setting of stbi. Default flip = true;
 	void FlipTextures(bool flip);
 	void ClearTextures();
+
+private:
+	unsigned int UploadTexture(unsigned char* data, int width, int height, int nrComponents);
 };
\ No newline at end of file
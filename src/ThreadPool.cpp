@@ -0,0 +1,100 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+	// state of a ParallelFor call. It is shared with the helpers because they
+	// may be dequeued after the call already returned.
+	struct ParallelForState {
+		std::function<void(int)> job;
+		int count;
+		std::atomic<int> next{ 0 };
+		std::atomic<int> done{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+
+		void Run()
+		{
+			int completed = 0;
+			for (int i = next++; i < count; i = next++) {
+				job(i);
+				completed++;
+			}
+			if (completed && (done += completed) == count) {
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		}
+	};
+}
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+{
+	numThreads = std::max(1u, numThreads);
+	workers.reserve(numThreads - 1);
+	for (unsigned int i = 1; i < numThreads; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		stopping = true;
+	}
+	tasksCondition.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::Instance()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& job, unsigned int maxThreads)
+{
+	if (count <= 0) return;
+	unsigned int numThreads = maxThreads ? std::min(maxThreads, NumThreads()) : NumThreads();
+	numThreads = std::min(numThreads, (unsigned int)count);
+	if (numThreads <= 1) {
+		for (int i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>();
+	state->job = job;
+	state->count = count;
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		for (unsigned int i = 1; i < numThreads; i++)
+			tasks.emplace_back([state]() { state->Run(); });
+	}
+	tasksCondition.notify_all();
+
+	state->Run();
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state]() { return state->done == state->count; });
+}
+
+unsigned int ThreadPool::NumThreads() const
+{
+	return workers.size() + 1;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(tasksMutex);
+			tasksCondition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty()) return;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+
+// fixed set of worker threads shared by the CPU heavy parts of the application
+class ThreadPool {
+public:
+	// creates numThreads - 1 workers, the thread calling ParallelFor is the remaining one
+	ThreadPool(unsigned int numThreads = std::thread::hardware_concurrency());
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+	~ThreadPool();
+
+	// pool shared by the whole application
+	static ThreadPool& Instance();
+
+	// runs job(i) for every i in [0, count) and returns when all of them are done.
+	// The calling thread takes part in the work, so nested calls can't deadlock.
+	// maxThreads limits the number of threads working on the jobs (0 = all of them).
+	void ParallelFor(int count, const std::function<void(int)>& job, unsigned int maxThreads = 0);
+	unsigned int NumThreads() const;
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex tasksMutex;
+	std::condition_variable tasksCondition;
+	bool stopping = false;
+
+	void WorkerLoop();
+};
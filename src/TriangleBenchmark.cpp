@@ -0,0 +1,122 @@
+#include "TriangleBenchmark.h"
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	// barycentrics closer than this to an edge make the closest triangle ambiguous in single precision
+	constexpr double EDGE_TOLERANCE = 1e-5;
+
+	struct ReferenceHit {
+		double distance = -1.0;
+		// smallest barycentric, negative if the ray misses the triangle
+		double margin = -1.0;
+	};
+
+	// Möller-Trumbore in double precision
+	ReferenceHit IntersectReference(const glm::dvec3& origin, const glm::dvec3& dir, const glm::dvec3& v0, const glm::dvec3& e1, const glm::dvec3& e2)
+	{
+		ReferenceHit hit;
+		glm::dvec3 p = glm::cross(dir, e2);
+		double det = glm::dot(e1, p);
+		if (det == 0.0)
+			return hit;
+		glm::dvec3 s = origin - v0;
+		double u = glm::dot(s, p) / det;
+		glm::dvec3 q = glm::cross(s, e1);
+		double v = glm::dot(dir, q) / det;
+		hit.distance = glm::dot(e2, q) / det;
+		hit.margin = std::min(std::min(u, v), 1.0 - u - v);
+		return hit;
+	}
+
+	glm::dvec3 GetVertex(const PackedTriangles& tris, int i)
+	{
+		return glm::dvec3(tris.v0x[i], tris.v0y[i], tris.v0z[i]);
+	}
+
+	glm::dvec3 GetFirstEdge(const PackedTriangles& tris, int i)
+	{
+		return glm::dvec3(tris.e1x[i], tris.e1y[i], tris.e1z[i]);
+	}
+
+	glm::dvec3 GetSecondEdge(const PackedTriangles& tris, int i)
+	{
+		return glm::dvec3(tris.e2x[i], tris.e2y[i], tris.e2z[i]);
+	}
+}
+
+std::vector<TriangleKernelTiming> TriangleBenchmark::Run(int numTriangles, int numRays)
+{
+	// small triangles scattered in a cube, the rays cross it from a sphere around it
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> offset(-0.05f, 0.05f);
+	PackedTriangles triangles;
+	triangles.Resize(numTriangles);
+	for (int i = 0; i < numTriangles; i++) {
+		glm::vec3 v0(position(rng), position(rng), position(rng));
+		triangles.Set(i, v0, v0 + glm::vec3(offset(rng), offset(rng), offset(rng)), v0 + glm::vec3(offset(rng), offset(rng), offset(rng)));
+	}
+	std::vector<glm::vec3> origins(numRays), directions(numRays);
+	for (int r = 0; r < numRays; r++) {
+		origins[r] = 3.0f * glm::normalize(glm::vec3(position(rng), position(rng), position(rng)));
+		directions[r] = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)) - origins[r]);
+	}
+
+	// closest triangle of every ray in double precision
+	std::vector<int> reference(numRays, -1);
+	std::vector<double> referenceDistances(numRays, 0.0);
+	for (int r = 0; r < numRays; r++) {
+		for (int i = 0; i < numTriangles; i++) {
+			ReferenceHit hit = IntersectReference(origins[r], directions[r], GetVertex(triangles, i), GetFirstEdge(triangles, i), GetSecondEdge(triangles, i));
+			if (hit.margin >= 0.0 && hit.distance > FLT_EPSILON && (reference[r] < 0 || hit.distance < referenceDistances[r])) {
+				reference[r] = i;
+				referenceDistances[r] = hit.distance;
+			}
+		}
+	}
+
+	std::vector<TriangleKernelTiming> timings;
+	std::vector<TriangleHit> hits(numRays);
+	for (int p = 0; p < Triangles_NumPaths; p++) {
+		TrianglePath path = TrianglePath(p);
+		if (!IsTrianglePathSupported(path))
+			continue;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < numRays; r++) {
+			hits[r] = TriangleHit{};
+			IntersectTriangles(triangles, origins[r], directions[r], 0, numTriangles, hits[r], path);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		TriangleKernelTiming timing;
+		timing.path = path;
+		timing.trianglesPerSecond = double(numTriangles) * numRays / seconds;
+		for (int r = 0; r < numRays; r++) {
+			int found = hits[r].index;
+			if (found == reference[r]) {
+				if (found >= 0)
+					timing.maxDistanceError = std::max(timing.maxDistanceError, float(std::abs(hits[r].distance - referenceDistances[r]) / referenceDistances[r]));
+				continue;
+			}
+			// a triangle hit near an edge can be missed (or hit) in single precision, as well as the one behind it
+			bool ambiguous = false;
+			for (int i : { found, reference[r] }) {
+				if (i < 0)
+					continue;
+				ReferenceHit hit = IntersectReference(origins[r], directions[r], GetVertex(triangles, i), GetFirstEdge(triangles, i), GetSecondEdge(triangles, i));
+				ambiguous = ambiguous || std::abs(hit.margin) < EDGE_TOLERANCE;
+			}
+			if (!ambiguous)
+				timing.mismatches++;
+		}
+		std::cout << GetTrianglePathName(path) << " triangle kernel: " << timing.trianglesPerSecond / 1e6 << " M triangles/s, "
+			<< timing.mismatches << " mismatches over " << numRays << " rays, max distance error " << timing.maxDistanceError << "\n";
+		timings.push_back(timing);
+	}
+	return timings;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "TriangleKernel.h"
+
+#include <vector>
+
+// triangles tested per second by a path of the kernel, checked against a double precision reference
+struct TriangleKernelTiming {
+	TrianglePath path = Triangles_Scalar;
+	double trianglesPerSecond = 0.0;
+	// rays whose closest triangle differs from the reference one, when neither is hit near one of its edges
+	int mismatches = 0;
+	// largest error of the distance of the closest hit, relative to the reference one
+	float maxDistanceError = 0.0f;
+};
+
+// casts rays through a cloud of synthetic triangles with every supported path of the kernel
+namespace TriangleBenchmark {
+	std::vector<TriangleKernelTiming> Run(int numTriangles = 100000, int numRays = 500);
+}
@@ -0,0 +1,219 @@
+#include "TriangleKernel.h"
+#include "SkinningKernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRIANGLES_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define TRIANGLES_AVX2
+#define TRIANGLES_AVX2_TARGET
+#elif defined(__GNUC__)
+#define TRIANGLES_AVX2
+#define TRIANGLES_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+static_assert(int(Triangles_SSE) == int(Skinning_SSE) && int(Triangles_AVX2) == int(Skinning_AVX2), "the paths must match");
+
+void PackedTriangles::Resize(int numTriangles)
+{
+	this->numTriangles = numTriangles;
+	int padded = numTriangles + TRIANGLE_PACKET_SIZE;
+	for (std::vector<float>* stream : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z })
+		stream->assign(padded, 0.0f);
+}
+
+void PackedTriangles::Set(int index, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+	glm::vec3 e1 = v1 - v0, e2 = v2 - v0;
+	v0x[index] = v0.x; v0y[index] = v0.y; v0z[index] = v0.z;
+	e1x[index] = e1.x; e1y[index] = e1.y; e1z[index] = e1.z;
+	e2x[index] = e2.x; e2y[index] = e2.y; e2z[index] = e2.z;
+}
+
+size_t PackedTriangles::GetMemoryBytes() const
+{
+	return 9 * v0x.size() * sizeof(float);
+}
+
+namespace {
+	bool Closer(float t, const TriangleHit& hit)
+	{
+		return t > FLT_EPSILON && (t < hit.distance || (hit.index < 0 && t == hit.distance));
+	}
+
+	// lanes of a packet that passed the test, in order so that ties keep the lowest index
+	bool ReduceLanes(int mask, int first, const float* t, const float* u, const float* v, TriangleHit& hit)
+	{
+		bool changed = false;
+		for (int lane = 0; mask; lane++, mask >>= 1) {
+			if ((mask & 1) && Closer(t[lane], hit)) {
+				hit = TriangleHit{ first + lane, t[lane], u[lane], v[lane] };
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	// reference implementation, one triangle at a time with glm
+	bool IntersectScalar(const PackedTriangles& tris, glm::vec3 origin, glm::vec3 dir, int begin, int end, TriangleHit& hit)
+	{
+		bool changed = false;
+		for (int i = begin; i < end; i++) {
+			glm::vec3 v0(tris.v0x[i], tris.v0y[i], tris.v0z[i]);
+			glm::vec3 e1(tris.e1x[i], tris.e1y[i], tris.e1z[i]);
+			glm::vec3 e2(tris.e2x[i], tris.e2y[i], tris.e2z[i]);
+			float t, u, v;
+			if (IntersectTriangle(origin, dir, v0, e1, e2, t, u, v) && Closer(t, hit)) {
+				hit = TriangleHit{ i, t, u, v };
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+#ifdef TRIANGLES_SSE
+	// 4 triangles per iteration, the same operations as the scalar path on the streams
+	bool IntersectSSE(const PackedTriangles& tris, glm::vec3 origin, glm::vec3 dir, int begin, int end, TriangleHit& hit)
+	{
+		constexpr int WIDTH = 4;
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+		const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+		alignas(16) float t[WIDTH], u[WIDTH], v[WIDTH];
+		bool changed = false;
+		for (int i = begin; i < end; i += WIDTH) {
+			__m128 e1x = _mm_loadu_ps(&tris.e1x[i]), e1y = _mm_loadu_ps(&tris.e1y[i]), e1z = _mm_loadu_ps(&tris.e1z[i]);
+			__m128 e2x = _mm_loadu_ps(&tris.e2x[i]), e2y = _mm_loadu_ps(&tris.e2y[i]), e2z = _mm_loadu_ps(&tris.e2z[i]);
+			// p = cross(dir, e2)
+			__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+			__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+			__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+			__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+			__m128 invDet = _mm_div_ps(one, det);
+			// s = origin - v0
+			__m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(&tris.v0x[i]));
+			__m128 sy = _mm_sub_ps(oy, _mm_loadu_ps(&tris.v0y[i]));
+			__m128 sz = _mm_sub_ps(oz, _mm_loadu_ps(&tris.v0z[i]));
+			__m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+			// q = cross(s, e1)
+			__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+			__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+			__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+			__m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+			__m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+			__m128 inside = _mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_and_ps(_mm_cmpge_ps(uu, zero), _mm_cmpge_ps(vv, zero)));
+			inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_add_ps(uu, vv), one));
+			int mask = _mm_movemask_ps(inside);
+			// lanes past the end of the range
+			if (end - i < WIDTH)
+				mask &= (1 << (end - i)) - 1;
+			if (!mask)
+				continue;
+			_mm_store_ps(t, tt);
+			_mm_store_ps(u, uu);
+			_mm_store_ps(v, vv);
+			changed = ReduceLanes(mask, i, t, u, v, hit) || changed;
+		}
+		return changed;
+	}
+#endif
+
+#ifdef TRIANGLES_AVX2
+	// 8 triangles per iteration
+	TRIANGLES_AVX2_TARGET bool IntersectAVX2(const PackedTriangles& tris, glm::vec3 origin, glm::vec3 dir, int begin, int end, TriangleHit& hit)
+	{
+		constexpr int WIDTH = 8;
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+		const __m256 dx = _mm256_set1_ps(dir.x), dy = _mm256_set1_ps(dir.y), dz = _mm256_set1_ps(dir.z);
+		const __m256 ox = _mm256_set1_ps(origin.x), oy = _mm256_set1_ps(origin.y), oz = _mm256_set1_ps(origin.z);
+		alignas(32) float t[WIDTH], u[WIDTH], v[WIDTH];
+		bool changed = false;
+		for (int i = begin; i < end; i += WIDTH) {
+			__m256 e1x = _mm256_loadu_ps(&tris.e1x[i]), e1y = _mm256_loadu_ps(&tris.e1y[i]), e1z = _mm256_loadu_ps(&tris.e1z[i]);
+			__m256 e2x = _mm256_loadu_ps(&tris.e2x[i]), e2y = _mm256_loadu_ps(&tris.e2y[i]), e2z = _mm256_loadu_ps(&tris.e2z[i]);
+			__m256 px = _mm256_fmsub_ps(dy, e2z, _mm256_mul_ps(dz, e2y));
+			__m256 py = _mm256_fmsub_ps(dz, e2x, _mm256_mul_ps(dx, e2z));
+			__m256 pz = _mm256_fmsub_ps(dx, e2y, _mm256_mul_ps(dy, e2x));
+			__m256 det = _mm256_fmadd_ps(e1x, px, _mm256_fmadd_ps(e1y, py, _mm256_mul_ps(e1z, pz)));
+			__m256 invDet = _mm256_div_ps(one, det);
+			__m256 sx = _mm256_sub_ps(ox, _mm256_loadu_ps(&tris.v0x[i]));
+			__m256 sy = _mm256_sub_ps(oy, _mm256_loadu_ps(&tris.v0y[i]));
+			__m256 sz = _mm256_sub_ps(oz, _mm256_loadu_ps(&tris.v0z[i]));
+			__m256 uu = _mm256_mul_ps(_mm256_fmadd_ps(sx, px, _mm256_fmadd_ps(sy, py, _mm256_mul_ps(sz, pz))), invDet);
+			__m256 qx = _mm256_fmsub_ps(sy, e1z, _mm256_mul_ps(sz, e1y));
+			__m256 qy = _mm256_fmsub_ps(sz, e1x, _mm256_mul_ps(sx, e1z));
+			__m256 qz = _mm256_fmsub_ps(sx, e1y, _mm256_mul_ps(sy, e1x));
+			__m256 vv = _mm256_mul_ps(_mm256_fmadd_ps(dx, qx, _mm256_fmadd_ps(dy, qy, _mm256_mul_ps(dz, qz))), invDet);
+			__m256 tt = _mm256_mul_ps(_mm256_fmadd_ps(e2x, qx, _mm256_fmadd_ps(e2y, qy, _mm256_mul_ps(e2z, qz))), invDet);
+			__m256 inside = _mm256_and_ps(_mm256_cmp_ps(det, zero, _CMP_NEQ_OQ), _mm256_and_ps(_mm256_cmp_ps(uu, zero, _CMP_GE_OQ), _mm256_cmp_ps(vv, zero, _CMP_GE_OQ)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(uu, vv), one, _CMP_LE_OQ));
+			int mask = _mm256_movemask_ps(inside);
+			if (end - i < WIDTH)
+				mask &= (1 << (end - i)) - 1;
+			if (!mask)
+				continue;
+			_mm256_store_ps(t, tt);
+			_mm256_store_ps(u, uu);
+			_mm256_store_ps(v, vv);
+			changed = ReduceLanes(mask, i, t, u, v, hit) || changed;
+		}
+		return changed;
+	}
+#endif
+}
+
+bool IntersectTriangle(glm::vec3 origin, glm::vec3 dir, glm::vec3 v0, glm::vec3 e1, glm::vec3 e2, float& t, float& u, float& v)
+{
+	// solves origin + t * dir = v0 + u * e1 + v * e2 with Cramer's rule
+	glm::vec3 p = glm::cross(dir, e2);
+	float det = glm::dot(e1, p);
+	// the ray is parallel to the triangle
+	if (det == 0.0f)
+		return false;
+	float invDet = 1.0f / det;
+	glm::vec3 s = origin - v0;
+	u = glm::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+	glm::vec3 q = glm::cross(s, e1);
+	v = glm::dot(dir, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+	t = glm::dot(e2, q) * invDet;
+	return true;
+}
+
+bool IntersectTriangles(const PackedTriangles& triangles, glm::vec3 origin, glm::vec3 dir, int begin, int end, TriangleHit& hit, TrianglePath path)
+{
+	if (!IsTrianglePathSupported(path))
+		path = Triangles_Scalar;
+	switch (path) {
+#ifdef TRIANGLES_AVX2
+	case Triangles_AVX2:
+		return IntersectAVX2(triangles, origin, dir, begin, end, hit);
+#endif
+#ifdef TRIANGLES_SSE
+	case Triangles_SSE:
+		return IntersectSSE(triangles, origin, dir, begin, end, hit);
+#endif
+	default:
+		return IntersectScalar(triangles, origin, dir, begin, end, hit);
+	}
+}
+
+bool IsTrianglePathSupported(TrianglePath path)
+{
+	// the cpu is checked once by the skinning kernel
+	return IsSkinningPathSupported(SkinningPath(path));
+}
+
+TrianglePath GetBestTrianglePath()
+{
+	return TrianglePath(GetBestSkinningPath());
+}
+
+const char* GetTrianglePathName(TrianglePath path)
+{
+	return GetSkinningPathName(SkinningPath(path));
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+// same instruction sets (and values) as SkinningPath
+enum TrianglePath
+{
+	Triangles_Scalar,
+	Triangles_SSE,
+	Triangles_AVX2,
+	Triangles_NumPaths
+};
+
+// triangles tested at once by the widest path, the streams are padded so that any range can be loaded in whole packets
+constexpr int TRIANGLE_PACKET_SIZE = 8;
+
+// triangles stored as a vertex and the two edges leaving it, in separate streams so several of them are loaded at once
+struct PackedTriangles {
+	std::vector<float> v0x, v0y, v0z;
+	std::vector<float> e1x, e1y, e1z;
+	std::vector<float> e2x, e2y, e2z;
+
+	// the padding triangles are degenerate and never hit
+	void Resize(int numTriangles);
+	void Set(int index, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+	int Size() const { return numTriangles; }
+	size_t GetMemoryBytes() const;
+
+private:
+	int numTriangles = 0;
+};
+
+struct TriangleHit {
+	// index of the triangle in the packed streams, -1 if none was hit
+	int index = -1;
+	float distance = FLT_MAX;
+	// weights of the second and third vertex, the first one has 1 - u - v
+	float u = 0.0f;
+	float v = 0.0f;
+};
+
+// Möller-Trumbore test of the ray against the triangle with a vertex v0 and the edges e1, e2 leaving it, on both sides.
+// On a hit gives the distance along the ray (negative behind the origin) and the barycentrics.
+bool IntersectTriangle(glm::vec3 origin, glm::vec3 dir, glm::vec3 v0, glm::vec3 e1, glm::vec3 e2, float& t, float& u, float& v);
+// Möller-Trumbore test of the ray against the triangles [begin, end). Both sides of the triangles are hit.
+// Keeps in hit the closest triangle farther than FLT_EPSILON, up to hit.distance included if hit.index is -1
+// and excluded otherwise. Equal distances keep the lowest index. Returns true if hit was changed.
+// Falls back to the scalar path if the given one is not supported.
+bool IntersectTriangles(const PackedTriangles& triangles, glm::vec3 origin, glm::vec3 dir, int begin, int end, TriangleHit& hit, TrianglePath path);
+// fastest path supported by the cpu
+TrianglePath GetBestTrianglePath();
+bool IsTrianglePathSupported(TrianglePath path);
+const char* GetTrianglePathName(TrianglePath path);
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Mesh.h"
+#include "BakedModel.h"
 #include "Camera.h"
 
 #include <glm/glm.hpp>
@@ -19,6 +19,8 @@ struct PickingInfo {
 struct IntersectionInfo {
 	std::optional<glm::vec3> hitPoint;
 	float distance = -1.0f;
+	// weights of the second and third vertex of the triangle hit
+	glm::vec2 barycentrics = glm::vec2(0.0f);
 };
 
 struct Line {
@@ -28,11 +30,11 @@ struct Line {
 
 float magnitude(glm::vec3 v);
 float raySphereIntersection(glm::vec3 rayOrigin, glm::vec3 rayDir, glm::vec3 sphereCenter, float radius);
-IntersectionInfo rayTriangleIntersection(const glm::vec3 rayOrigin, const glm::vec3 rayDir, const Vertex& v1, const Vertex& v2, const Vertex& v3);
-int getClosestVertexIndex(const glm::vec3 point, const Mesh& m, int v1, int v2, int v3);
-int getClosestVertexIndex(const glm::vec3 point, const Mesh& m, Face& f);
-Vertex getClosestVertex(const glm::vec3 point, const Mesh& m, int v1, int v2, int v3);
-Vertex getClosestVertex(const glm::vec3 point, const Mesh& m, Face& f);
-Line getClosestLineIndex(const glm::vec3 point, const Mesh& m, int v1, int v2, int v3);
-Line getClosestLineIndex(const glm::vec3 point, const Mesh& m, Face& f);
+IntersectionInfo rayTriangleIntersection(const glm::vec3 rayOrigin, const glm::vec3 rayDir, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3);
+int getClosestVertexIndex(const glm::vec3 point, const BakedMesh& m, int v1, int v2, int v3);
+int getClosestVertexIndex(const glm::vec3 point, const BakedMesh& m, Face& f);
+glm::vec3 getClosestVertex(const glm::vec3 point, const BakedMesh& m, int v1, int v2, int v3);
+glm::vec3 getClosestVertex(const glm::vec3 point, const BakedMesh& m, Face& f);
+Line getClosestLineIndex(const glm::vec3 point, const BakedMesh& m, int v1, int v2, int v3);
+Line getClosestLineIndex(const glm::vec3 point, const BakedMesh& m, Face& f);
 float getPointLineDist(const glm::vec3 l1, const glm::vec3 l2, const glm::vec3 point);
\ No newline at end of file
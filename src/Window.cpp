@@ -35,17 +35,78 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 // glfw: whenever the mouse moves, this callback is called
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
-	process_mouse_movement(window, xpos, ypos);
+	StatusManager* status = (StatusManager*)glfwGetWindowUserPointer(window);
+	InputEvent event{ Input_MouseMove };
+	event.x = xpos;
+	event.y = ypos;
+	event.time = glfwGetTime();
+	status->inputQueue.Push(event);
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
 	StatusManager* status = (StatusManager*)glfwGetWindowUserPointer(window);
-	status->camera.ProcessMouseScroll(yoffset);
+	InputEvent event{ Input_Scroll };
+	event.x = xoffset;
+	event.y = yoffset;
+	event.time = glfwGetTime();
+	status->inputQueue.Push(event);
 }
 
 void key_press_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	StatusManager* status = (StatusManager*)glfwGetWindowUserPointer(window);
+	InputEvent event{ Input_Key };
+	event.code = key;
+	event.scancode = scancode;
+	event.action = action;
+	event.mods = mods;
+	event.time = glfwGetTime();
+	status->inputQueue.Push(event);
+}
+
+void on_mouse_click_callback(GLFWwindow* window, int button, int action, int mods)
+{
+	StatusManager* status = (StatusManager*)glfwGetWindowUserPointer(window);
+	InputEvent event{ Input_MouseButton };
+	event.code = button;
+	event.action = action;
+	event.mods = mods;
+	event.time = glfwGetTime();
+	status->inputQueue.Push(event);
+}
+
+// handles the events queued since the last frame in order, the moves between two other events are merged so
+// picking and tweaking run at most once per frame, or once between two clicks or key presses
+void process_input(GLFWwindow* window)
+{
+	StatusManager* status = (StatusManager*)glfwGetWindowUserPointer(window);
+	for (const InputEvent& event : status->inputQueue.TakeCoalesced()) {
+		switch (event.type) {
+		case Input_MouseMove:
+			process_mouse_movement(window, float(event.x), float(event.y));
+			break;
+		case Input_MouseButton:
+			process_mouse_click(window, event.code, event.action, event.mods);
+			break;
+		case Input_Key:
+			process_key_press(window, event.code, event.scancode, event.action, event.mods);
+			break;
+		case Input_Scroll:
+			process_scroll(window, event.x, event.y);
+			break;
+		}
+	}
+}
+
+void process_scroll(GLFWwindow* window, double xoffset, double yoffset)
+{
+	StatusManager* status = (StatusManager*)glfwGetWindowUserPointer(window);
+	status->camera.ProcessMouseScroll(yoffset);
+}
+
+void process_key_press(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	if (action == GLFW_RELEASE || glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS || glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS)
 		return;
@@ -123,12 +184,13 @@ void key_press_callback(GLFWwindow* window, int key, int scancode, int action, i
 	}
 }
 
-void on_mouse_click_callback(GLFWwindow* window, int button, int action, int mods)
+void process_mouse_click(GLFWwindow* window, int button, int action, int mods)
 {
 	StatusManager* status = (StatusManager*)glfwGetWindowUserPointer(window);
 
 
-	if (!status->pause) {
+	// while playing the pose is only baked to pick on it
+	if (!status->pause && !status->bakedModel) {
 		process_mouse_movement = &update_mouse_last_pos;
 		return;
 	}
@@ -137,7 +199,8 @@ void on_mouse_click_callback(GLFWwindow* window, int button, int action, int mod
 
 	if (action == GLFW_RELEASE)
 	{
-		process_mouse_movement = &picking;
+		// while playing the hovered face is updated every frame
+		process_mouse_movement = status->pause ? &picking : &update_mouse_last_pos;
 		if (button == GLFW_MOUSE_BUTTON_LEFT && status->IsChanging())
 			status->EndChange();
 		return;
@@ -159,32 +222,18 @@ void on_mouse_click_callback(GLFWwindow* window, int button, int action, int mod
 		//check for multiple selection
 		if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_RELEASE) {
 			status->selectedVertices.clear();
-			status->selectedVerticesPointers.clear();
-		}
-		if (status->selectionMode == Mode_Vertex && status->SelectHoveredVertex())
-		{
-			status->StartChange();
-			process_mouse_movement = &tweak;
-			return;
 		}
-		else if (status->selectionMode == Mode_Edge && status->SelectHoveredEdge())
-		{
-			status->StartChange();
-			process_mouse_movement = &tweak;
+		bool selected = (status->selectionMode == Mode_Vertex && status->SelectHoveredVertex())
+			|| (status->selectionMode == Mode_Edge && status->SelectHoveredEdge())
+			|| (status->selectionMode == Mode_Face && status->SelectHoveredFace());
+		if (!selected)
 			return;
-		}
-		else if (status->selectionMode == Mode_Face && status->SelectHoveredFace())
-		{
-			status->StartChange();
-			process_mouse_movement = &tweak;
-			return;
-		}
 	}
-	else{
-		status->StartChange();
-		process_mouse_movement = &tweak;
+	// the selected vertices are only moved while paused
+	if (!status->pause)
 		return;
-	}
+	status->StartChange();
+	process_mouse_movement = &tweak;
 }
 
 void rotate(GLFWwindow* window, float xpos, float ypos) {
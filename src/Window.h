@@ -34,6 +34,12 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void key_press_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void on_mouse_click_callback(GLFWwindow* window, int button, int action, int mods);
 
+//input handling, the callbacks only queue the events that are handled here once per frame
+void process_input(GLFWwindow* window);
+void process_scroll(GLFWwindow* window, double xoffset, double yoffset);
+void process_key_press(GLFWwindow* window, int key, int scancode, int action, int mods);
+void process_mouse_click(GLFWwindow* window, int button, int action, int mods);
+
 //mouse movement
 inline void (*process_mouse_movement)(GLFWwindow*, float, float);
 void rotate(GLFWwindow* window, float xpos, float ypos);